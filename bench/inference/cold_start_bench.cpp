@@ -0,0 +1,74 @@
+#include <torch/torch.h>
+#include <torch/script.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <config.hpp>
+#include "inference/model_registry.hpp"
+
+int main()
+{
+    std::cout << std::fixed << std::setprecision(1);
+    if (!std::filesystem::exists(MODEL_RESNET18))
+    {
+        std::cerr << "Missing " << MODEL_RESNET18 << "; create it with create_restnet18.py in " << SCRIPTS_MODLES_PATH
+                  << "/.\n";
+        return 1;
+    }
+
+    model_registry_options uncached;
+    uncached.use_cache = false;
+    model_registry_options cached;
+    std::filesystem::remove(model_registry::cache_path(MODEL_RESNET18, cached));
+
+    std::cout << "\nEnvironment: " << model_registry::environment_key() << "\n";
+    std::cout << "load + freeze + optimize (no cache): " << model_registry::load_model(MODEL_RESNET18, uncached)->load_ms
+              << " ms\n";
+    std::cout << "first start (builds cache):          " << model_registry::load_model(MODEL_RESNET18, cached)->load_ms
+              << " ms\n";
+    auto warm = model_registry::load_model(MODEL_RESNET18, cached);
+    std::cout << "later start (from cache):            " << warm->load_ms << " ms"
+              << (warm->from_cache ? "" : " (cache not used)") << "\n";
+
+    // Hot swap under load: clients keep calling get() + forward while a new version is published
+    model_registry registry;
+    registry.add("resnet18", MODEL_RESNET18);
+    auto image = torch::randn({1, 3, 224, 224});
+    std::atomic<bool> running(true), measuring(false);
+    std::vector<double> worst(4, 0.0);
+    std::vector<std::thread> clients;
+    for (size_t c = 0; c < worst.size(); ++c)
+    {
+        clients.emplace_back([&, c]() {
+            c10::InferenceMode guard;
+            while (running)
+            {
+                auto start = std::chrono::steady_clock::now();
+                registry.get("resnet18")->module.forward({image});
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                if (measuring)
+                    worst[c] = std::max(worst[c], ms);
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+    measuring = true; // past the lazy first load
+    auto start = std::chrono::steady_clock::now();
+    registry.swap("resnet18", MODEL_RESNET18);
+    double swap_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    running = false;
+    for (auto &t : clients)
+        t.join();
+
+    std::cout << "hot swap took " << swap_ms << " ms; worst request during it: "
+              << *std::max_element(worst.begin(), worst.end()) << " ms\n";
+    std::cout << "\nDone.\n";
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include <torch/torch.h>
+#include <torch/script.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <config.hpp>
+#include "inference/inference_engine.hpp"
+
+struct variant {
+    std::string name;
+    std::string path;
+    bool channels_last;
+};
+
+torch::Tensor layout(const torch::Tensor &x, bool channels_last)
+{
+    return channels_last ? x.contiguous(torch::MemoryFormat::ChannelsLast) : x.contiguous();
+}
+
+double median_ms(std::vector<double> samples)
+{
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+int main()
+{
+    std::cout << std::fixed << std::setprecision(2);
+    torch::manual_seed(0);
+
+    const std::vector<variant> variants = {
+        {"fp32 NCHW", MODEL_RESNET18, false},
+        {"fp32 channels-last", MODEL_RESNET18, true},
+        {"int8 NCHW", MODEL_RESNET18_INT8, false},
+        {"int8 channels-last", MODEL_RESNET18_INT8, true},
+    };
+
+    // Fixed evaluation set; top-1 agreement is measured against the first (fp32 NCHW) variant
+    const int64_t eval_images = 256, batch = 32, latency_runs = 50;
+    auto images = torch::randn({eval_images, 3, 224, 224});
+    torch::Tensor reference_top1;
+
+    std::cout << "\nResNet18 CPU inference, " << at::get_num_threads() << " intra-op threads\n";
+    std::cout << std::setw(22) << "variant" << std::setw(11) << "size MB" << std::setw(14) << "b=1 p50 ms"
+              << std::setw(12) << "images/s" << std::setw(14) << "top-1 agree" << "\n";
+
+    for (const auto &v : variants)
+    {
+        if (!std::filesystem::exists(v.path))
+        {
+            std::cout << std::setw(22) << v.name << "  missing " << v.path
+                      << " (run create_restnet18.py --int8 in " << SCRIPTS_MODLES_PATH << ")\n";
+            continue;
+        }
+
+        auto module = torch::jit::load(v.path);
+        if (v.channels_last)
+            inference_engine::to_channels_last(module);
+        module = inference_engine::optimize_module(module);
+        double size_mb = std::filesystem::file_size(v.path) / (1024.0 * 1024.0);
+
+        // Only after the conversion: set_data is not allowed on inference tensors
+        c10::InferenceMode guard;
+
+        // Warm-up at both shapes
+        auto one = layout(images.slice(0, 0, 1), v.channels_last);
+        auto many = layout(images.slice(0, 0, batch), v.channels_last);
+        for (int i = 0; i < 3; ++i)
+        {
+            module.forward({one});
+            module.forward({many});
+        }
+
+        // Latency: single image, median of repeated runs
+        std::vector<double> latencies;
+        for (int i = 0; i < latency_runs; ++i)
+        {
+            auto start = std::chrono::steady_clock::now();
+            module.forward({one});
+            latencies.push_back(
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+
+        // Throughput and predictions: the whole evaluation set in batches
+        std::vector<torch::Tensor> top1;
+        auto start = std::chrono::steady_clock::now();
+        for (int64_t b = 0; b < eval_images; b += batch)
+        {
+            auto x = layout(images.slice(0, b, std::min(eval_images, b + batch)), v.channels_last);
+            top1.push_back(module.forward({x}).toTensor().argmax(1));
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        auto predictions = torch::cat(top1);
+
+        if (!reference_top1.defined())
+            reference_top1 = predictions;
+        double agreement = predictions.eq(reference_top1).to(torch::kDouble).mean().item<double>() * 100.0;
+
+        std::cout << std::setw(22) << v.name << std::setw(11) << size_mb << std::setw(14) << median_ms(latencies)
+                  << std::setw(12) << eval_images / seconds << std::setw(13) << agreement << "%\n";
+    }
+
+    std::cout << "\nDone.\n";
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include <torch/torch.h>
+#include <torch/script.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include <config.hpp>
+#include "inference/inference_engine.hpp"
+
+struct bench_config {
+    const char *name;
+    bool optimize;
+    int replicas;
+    int64_t max_batch;
+    int clients;
+};
+
+// Closed-loop load: every client submits one image and waits for it before the next.
+void run(const torch::jit::Module &module, const bench_config &config, int requests_per_client)
+{
+    inference_engine_options options;
+    options.optimize = config.optimize;
+    options.replicas = config.replicas;
+    options.max_batch = config.max_batch;
+    inference_engine engine(module.clone(), options);
+
+    auto image = torch::randn({3, 224, 224});
+    std::vector<std::thread> clients;
+    for (int c = 0; c < config.clients; ++c)
+    {
+        clients.emplace_back([&]() {
+            for (int i = 0; i < requests_per_client; ++i)
+                engine.infer(image);
+        });
+    }
+    for (auto &t : clients)
+        t.join();
+
+    auto s = engine.stats();
+    std::cout << std::setw(24) << config.name << std::setw(9) << config.replicas << std::setw(7) << config.max_batch
+              << std::setw(9) << config.clients << std::setw(11) << s.mean_batch_size << std::setw(12)
+              << s.p50_latency_us / 1000.0 << std::setw(12) << s.p99_latency_us / 1000.0 << std::setw(12)
+              << s.requests_per_second << "\n";
+}
+
+int main()
+{
+    std::cout << std::fixed << std::setprecision(2);
+
+    torch::jit::Module resnet;
+    try
+    {
+        resnet = torch::jit::load(MODEL_RESNET18);
+    }
+    catch (const torch::Error &error)
+    {
+        std::cerr << "Could not load scriptmodule from file " << MODEL_RESNET18 << ".\n"
+                  << "You can create this file using the provided Python script 'create_resnet18.py' "
+                  << "in " << SCRIPTS_MODLES_PATH << "/.\n";
+        return 1;
+    }
+
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    const std::vector<bench_config> configs = {
+        {"scripted, unbatched", false, 1, 1, 1},
+        {"optimized, unbatched", true, 1, 1, 1},
+        {"optimized, batched", true, 1, 16, 16},
+        {"optimized, 2 replicas", true, 2, 8, 16},
+        {"optimized, 4 replicas", true, 4, 8, 32},
+        {"optimized, per-core", true, (int)cores, 1, (int)cores},
+    };
+
+    std::cout << "\nResNet18 CPU inference (" << cores << " hardware threads)\n";
+    std::cout << std::setw(24) << "config" << std::setw(9) << "replicas" << std::setw(7) << "batch" << std::setw(9)
+              << "clients" << std::setw(11) << "avg batch" << std::setw(12) << "p50 ms" << std::setw(12) << "p99 ms"
+              << std::setw(12) << "images/s" << "\n";
+    for (const auto &config : configs)
+        run(resnet, config, 2000 / config.clients + 8);
+
+    std::cout << "\nDone.\n";
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include <torch/torch.h>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include "trace/trace.hpp"
+#include "trace/torch_events.hpp"
+
+// Cost of a trace span while the tracer is stopped and running, and what forwarding
+// torch operator events adds to a small-tensor operator loop.
+
+template <typename F>
+double ns_per_call(int64_t calls, F &&fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int64_t i = 0; i < calls; ++i)
+        fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / calls;
+}
+
+int main()
+{
+    std::cout << std::fixed << std::setprecision(1);
+    const int64_t spans = 10000000;
+    const int64_t ops = 200000;
+
+    auto empty_span = [] { trace_span span("bench.span", "bench"); };
+
+    double stopped = ns_per_call(spans, empty_span);
+    tracer::start();
+    double running = ns_per_call(spans, empty_span);
+    tracer::stop();
+
+    std::cout << "trace_span, tracer stopped: " << stopped << " ns\n";
+    std::cout << "trace_span, tracer running: " << running << " ns\n";
+
+    // Small tensors so per-operator overhead dominates
+    auto a = torch::randn({8, 8});
+    auto b = torch::randn({8, 8});
+    auto out = torch::empty({8, 8});
+    auto add = [&] { torch::add_out(out, a, b); };
+
+    double baseline = ns_per_call(ops, add);
+    double with_callback, with_tracing;
+    {
+        torch_events events;
+        with_callback = ns_per_call(ops, add);
+        tracer::start();
+        with_tracing = ns_per_call(ops, add);
+        tracer::stop();
+    }
+
+    std::cout << "\nadd_out on 8x8 tensors:\n";
+    std::cout << "  no callbacks:                 " << baseline << " ns\n";
+    std::cout << "  torch_events, tracer stopped: " << with_callback << " ns\n";
+    std::cout << "  torch_events, tracer running: " << with_tracing << " ns\n";
+
+    // The last session holds the traced operator loop
+    const char *path = "trace_bench.json";
+    tracer::write_chrome_trace(path);
+    std::cout << "\nLast " << tracer::collect().size() << " spans written to " << path << " ("
+              << tracer::dropped() << " overwritten)\n";
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include <torch/torch.h>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include "training/parallel_trainer.hpp"
+
+// Fingerprint-sized MLP classifier: 32 features -> 16 zones
+torch::nn::Sequential make_model()
+{
+    torch::manual_seed(0);
+    return torch::nn::Sequential(torch::nn::Linear(32, 256), torch::nn::ReLU(), torch::nn::Linear(256, 256),
+                                 torch::nn::ReLU(), torch::nn::Linear(256, 16));
+}
+
+torch::Tensor loss(torch::nn::Module &replica, const torch::Tensor &x, const torch::Tensor &y)
+{
+    auto &net = dynamic_cast<torch::nn::SequentialImpl &>(replica);
+    return torch::nn::functional::cross_entropy(net.forward(x), y);
+}
+
+int main()
+{
+    std::cout << std::fixed << std::setprecision(0);
+    const int64_t rows = 1 << 18, batch = 4096;
+    const int epochs = 2;
+    auto features = torch::randn({rows, 32});
+    auto labels = torch::randint(0, 16, {rows}, torch::kLong);
+    const int cores = (int)std::max(1u, std::thread::hardware_concurrency());
+
+    auto time_epochs = [&](auto &&train_step) {
+        auto start = std::chrono::steady_clock::now();
+        for (int e = 0; e < epochs; ++e)
+            for (int64_t b = 0; b + batch <= rows; b += batch)
+                train_step(features.slice(0, b, b + batch), labels.slice(0, b, b + batch));
+        return epochs * (rows / batch) * batch /
+               std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    std::cout << "\nMLP 32-256-256-16, batch " << batch << ", " << cores << " hardware threads\n";
+    std::cout << std::setw(28) << "setup" << std::setw(14) << "samples/s" << std::setw(10) << "speedup" << "\n";
+
+    // Baseline: the autogradExTwo-style loop, single-threaded
+    at::set_num_threads(1);
+    double baseline;
+    {
+        auto model = make_model();
+        torch::optim::SGD optimizer(model->parameters(), torch::optim::SGDOptions(0.01));
+        baseline = time_epochs([&](const torch::Tensor &x, const torch::Tensor &y) {
+            optimizer.zero_grad();
+            auto l = loss(*model, x, y);
+            l.backward();
+            optimizer.step();
+        });
+    }
+    std::cout << std::setw(28) << "single loop, 1 thread" << std::setw(14) << baseline << std::setw(9) << 1.0
+              << "x\n";
+
+    // Same loop with intra-op parallelism only
+    at::set_num_threads(cores);
+    {
+        auto model = make_model();
+        torch::optim::SGD optimizer(model->parameters(), torch::optim::SGDOptions(0.01));
+        double rate = time_epochs([&](const torch::Tensor &x, const torch::Tensor &y) {
+            optimizer.zero_grad();
+            auto l = loss(*model, x, y);
+            l.backward();
+            optimizer.step();
+        });
+        std::cout << std::setw(28) << "single loop, intra-op" << std::setw(14) << rate << std::setw(9)
+                  << std::setprecision(2) << rate / baseline << std::setprecision(0) << "x\n";
+    }
+
+    for (int workers = 1; workers <= cores; workers *= 2)
+    {
+        auto model = make_model();
+        torch::optim::SGD optimizer(model->parameters(), torch::optim::SGDOptions(0.01));
+        parallel_trainer trainer(model.ptr(), loss, workers);
+        double rate = time_epochs([&](const torch::Tensor &x, const torch::Tensor &y) {
+            trainer.step(x, y);
+            optimizer.step();
+        });
+        std::cout << std::setw(28) << "parallel_trainer, " + std::to_string(workers) + " workers" << std::setw(14)
+                  << rate << std::setw(9) << std::setprecision(2) << rate / baseline << std::setprecision(0)
+                  << "x\n";
+    }
+
+    std::cout << "\nDone.\n";
+    return 0;
+}
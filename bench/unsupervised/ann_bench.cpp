@@ -0,0 +1,56 @@
+#include <torch/torch.h>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include "unsupervised/simulator.hpp"
+#include "unsupervised/decomposition.hpp"
+#include "unsupervised/ivf_index.hpp"
+
+// Fraction of the exact k nearest neighbours that the approximate search returned.
+double recall_at_k(const torch::Tensor &approx_ids, const torch::Tensor &exact_ids)
+{
+    auto hits = approx_ids.unsqueeze(2).eq(exact_ids.unsqueeze(1)).any(2).sum();
+    return hits.item<double>() / (double)exact_ids.numel();
+}
+
+int main()
+{
+    std::cout << std::fixed << std::setprecision(3);
+    torch::manual_seed(123);
+
+    // Fingerprint database in PCA space, plus held-out queries projected the same way
+    const int n_database = 200000, n_queries = 2000, k = 10;
+    auto data = sampleSimulator(n_database + n_queries, 32);
+    auto model = pca_fit(data.slice(0, 0, n_database));
+    auto database = model.project(data.slice(0, 0, n_database)).cpu();
+    auto queries = model.project(data.slice(0, n_database)).cpu();
+
+    const int n_lists = 1024;
+    ivf_index index(n_lists);
+    auto start = std::chrono::steady_clock::now();
+    index.build(database, /*seed=*/123);
+    double build_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    auto exact = exact_knn(database, queries, k);
+    double exact_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "\nIVF-Flat over " << n_database << " fingerprints (D=" << database.size(1) << ", lists=" << n_lists
+              << "), built in " << build_s << " s\n";
+    std::cout << "Brute force: " << exact_ms / n_queries * 1000.0 << " us/query\n\n";
+    std::cout << std::setw(8) << "n_probe" << std::setw(14) << "recall@" + std::to_string(k) << std::setw(14)
+              << "us/query" << std::setw(14) << "queries/s" << "\n";
+
+    for (int n_probe : {1, 2, 4, 8, 16, 32, 64})
+    {
+        start = std::chrono::steady_clock::now();
+        auto approx = index.search(queries, k, n_probe);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << std::setw(8) << n_probe << std::setw(14) << recall_at_k(approx.second, exact.second)
+                  << std::setw(14) << ms / n_queries * 1000.0 << std::setw(14) << n_queries / (ms / 1000.0) << "\n";
+    }
+
+    std::cout << "\nDone.\n";
+    return 0;
+}
@@ -0,0 +1,250 @@
+#include <torch/torch.h>
+#include <torch/version.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <sys/resource.h>
+#include "unsupervised/bounded_kmeans.hpp"
+#include "unsupervised/decomposition.hpp"
+#include "unsupervised/kmeans.hpp"
+#include "unsupervised/minibatch_kmeans.hpp"
+
+// Benchmark harness for the PCA solvers and k-means variants.
+//
+// Usage: bench_unsupervised [--quick] [--out <file.json>] [--filter <substring>] [--repetitions <r>]
+//
+// Every case runs on a fresh synthetic blob dataset for each point of the n × d × K × threads
+// grid and reports the median and minimum wall time, points/s and the peak resident set
+// size reached while it ran, as JSON in the Google Benchmark layout (context + benchmarks).
+// Progress goes to stderr; the algorithms' own logging is muted while they are timed.
+
+using json = nlohmann::json;
+
+namespace
+{
+    struct bench_args {
+        bool quick = false;
+        std::string out = "bench_unsupervised.json";
+        std::string filter;
+        int repetitions = 3;
+    };
+
+    struct grid_point {
+        int64_t n, d, K;
+        int threads;
+    };
+
+    // Resets the kernel's peak-RSS watermark (Linux >= 4.0) so each case reports its own peak.
+    void reset_peak_rss()
+    {
+        std::ofstream clear_refs("/proc/self/clear_refs");
+        if (clear_refs)
+            clear_refs << "5";
+    }
+
+    // Peak resident set size in MiB: VmHWM, or the process-wide maximum where that is unavailable.
+    double peak_rss_mib()
+    {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line))
+        {
+            if (line.rfind("VmHWM:", 0) == 0)
+                return std::stod(line.substr(6)) / 1024.0; // reported in kB
+        }
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss / 1024.0;
+    }
+
+    // Silences std::cout for the lifetime of the object.
+    class mute_cout
+    {
+    private:
+        std::ostringstream sink;
+        std::streambuf *saved;
+
+    public:
+        mute_cout() : saved(std::cout.rdbuf(sink.rdbuf())) {}
+
+        ~mute_cout() { std::cout.rdbuf(saved); }
+    };
+
+    // K Gaussian blobs in d dimensions, so the clustering has structure to find.
+    torch::Tensor make_blobs(int64_t n, int64_t d, int64_t K)
+    {
+        torch::manual_seed(1234);
+        auto centers = torch::randn({K, d}) * 6.0;
+        auto labels = torch::randint(0, K, {n}, torch::kLong);
+        return centers.index_select(0, labels) + torch::randn({n, d});
+    }
+
+    // Keeps ~10% of the entries, as a stand-in for sparse fingerprints.
+    torch::Tensor sparsify(const torch::Tensor &dense)
+    {
+        torch::manual_seed(4321);
+        return (dense * torch::rand_like(dense).lt(0.1)).to_sparse_csr();
+    }
+
+    bench_args parse(int argc, char **argv)
+    {
+        bench_args args;
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "--quick")
+                args.quick = true;
+            else if (arg == "--out" && i + 1 < argc)
+                args.out = argv[++i];
+            else if (arg == "--filter" && i + 1 < argc)
+                args.filter = argv[++i];
+            else if (arg == "--repetitions" && i + 1 < argc)
+                args.repetitions = std::max(1, std::atoi(argv[++i]));
+            else
+                throw std::invalid_argument("Unknown argument: " + arg);
+        }
+        return args;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bench_args args;
+    try
+    {
+        args = parse(argc, argv);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << "\nUsage: " << argv[0]
+                  << " [--quick] [--out <file.json>] [--filter <substring>] [--repetitions <r>]\n";
+        return 1;
+    }
+
+    const int cores = (int)std::max(1u, std::thread::hardware_concurrency());
+    std::vector<int64_t> ns = args.quick ? std::vector<int64_t>{20000} : std::vector<int64_t>{100000, 1000000};
+    std::vector<int64_t> ds = args.quick ? std::vector<int64_t>{8} : std::vector<int64_t>{8, 32};
+    std::vector<int64_t> ks = args.quick ? std::vector<int64_t>{16} : std::vector<int64_t>{16, 256};
+    std::vector<int> threads = cores > 1 ? std::vector<int>{1, cores} : std::vector<int>{1};
+    const int iters = 10;              // fixed k-means iterations (tol = 0) so variants compare per iteration
+    const int64_t elkan_max_nk = 50000000; // Elkan keeps n·K lower bounds
+
+    json report;
+    std::time_t now = std::time(nullptr);
+    char date[32];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+    report["context"] = {{"date", date},
+                         {"executable", argv[0]},
+                         {"num_cpus", cores},
+                         {"libtorch_version", TORCH_VERSION},
+                         {"repetitions", args.repetitions},
+                         {"kmeans_iterations", iters}};
+    report["benchmarks"] = json::array();
+
+    // Times 'fn' for the grid point and appends one JSON record.
+    // 'points' is the number of points processed per run, for the throughput column.
+    auto run = [&](const std::string &algorithm, const grid_point &g, int64_t points,
+                   const std::function<void()> &fn) {
+        std::ostringstream name;
+        name << algorithm << "/n:" << g.n << "/d:" << g.d;
+        if (g.K > 0)
+            name << "/K:" << g.K;
+        name << "/threads:" << g.threads;
+        if (!args.filter.empty() && name.str().find(args.filter) == std::string::npos)
+            return;
+
+        at::set_num_threads(g.threads);
+        std::cerr << name.str() << " ... " << std::flush;
+
+        std::vector<double> times;
+        double peak = 0;
+        for (int r = 0; r < args.repetitions; ++r)
+        {
+            reset_peak_rss();
+            auto start = std::chrono::steady_clock::now();
+            {
+                mute_cout mute;
+                fn();
+            }
+            times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            peak = std::max(peak, peak_rss_mib());
+        }
+        std::sort(times.begin(), times.end());
+        double median = times[times.size() / 2];
+
+        report["benchmarks"].push_back({{"name", name.str()},
+                                        {"algorithm", algorithm},
+                                        {"n", g.n},
+                                        {"d", g.d},
+                                        {"K", g.K},
+                                        {"threads", g.threads},
+                                        {"repetitions", args.repetitions},
+                                        {"real_time_ms", median},
+                                        {"min_time_ms", times.front()},
+                                        {"points_per_second", points / (median / 1000.0)},
+                                        {"peak_rss_mib", peak}});
+        std::cerr << median << " ms\n";
+    };
+
+    for (int64_t n : ns)
+    {
+        for (int64_t d : ds)
+        {
+            // PCA solvers do not depend on K
+            auto data = make_blobs(n, d, 16);
+            auto sparse = sparsify(data);
+            for (int t : threads)
+            {
+                grid_point g{n, d, 0, t};
+                const int64_t rank = std::min<int64_t>(d, 8);
+                run("pca_fit", g, n, [&] { pca_fit(data); });
+                run("truncated_svd", g, n, [&] { truncated_svd(data, rank); });
+                run("sparse_pca_fit", g, n, [&] { sparse_pca_fit(sparse, rank); });
+            }
+
+            for (int64_t K : ks)
+            {
+                auto blobs = make_blobs(n, d, K);
+                for (int t : threads)
+                {
+                    grid_point g{n, d, K, t};
+                    const int64_t points = n * iters;
+                    run("kmeans", g, points, [&] { kmeans(blobs, (int)n, (int)K, iters, 0.0f, false); });
+                    run("kmeans_fit_n_init4", g, 4 * points, [&] {
+                        kmeans_options options((int)K);
+                        options.max_iters = iters;
+                        options.tol = 0.0f;
+                        options.n_init = 4;
+                        options.n_threads = t;
+                        kmeans_fit(blobs, options);
+                    });
+                    run("kmeans_hamerly", g, points,
+                        [&] { kmeans_hamerly(blobs, (int)K, iters, 0.0f, nullptr, false); });
+                    if (n * K <= elkan_max_nk)
+                        run("kmeans_elkan", g, points,
+                            [&] { kmeans_elkan(blobs, (int)K, iters, 0.0f, nullptr, false); });
+                    run("minibatch_kmeans", g, points, [&] {
+                        minibatch_kmeans model((int)K);
+                        tensor_batch_source source(blobs, 4096);
+                        model.fit(source, iters);
+                    });
+                }
+            }
+        }
+    }
+
+    std::ofstream out(args.out);
+    out << report.dump(2) << "\n";
+    std::cerr << "Wrote " << report["benchmarks"].size() << " results to " << args.out << "\n";
+    return 0;
+}
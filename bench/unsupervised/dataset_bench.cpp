@@ -0,0 +1,73 @@
+#include <torch/torch.h>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include "unsupervised/ocid_dataset.hpp"
+#include "unsupervised/simulator.hpp"
+
+// The per-example path, as in mnistAsInputPipeline: one Example per row, then Stack<>.
+class per_example_dataset : public torch::data::datasets::Dataset<per_example_dataset>
+{
+private:
+    torch::Tensor features, targets;
+
+public:
+    per_example_dataset(torch::Tensor features, torch::Tensor targets) : features(features), targets(targets) {}
+
+    torch::data::Example<> get(size_t index) override { return {features[index], targets[index]}; }
+
+    torch::optional<size_t> size() const override { return (size_t)features.size(0); }
+};
+
+// Drains one epoch and returns samples/s.
+template <typename Loader>
+double drain(Loader &loader)
+{
+    int64_t samples = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (auto &batch : *loader)
+        samples += batch.data.size(0);
+    return samples / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+    std::cout << std::fixed << std::setprecision(0);
+    const int64_t rows = 2000000;
+    const size_t batch_size = 1024;
+
+    auto features = simulate_fingerprints(rows);
+    auto targets = torch::randint(0, 16, {rows}, torch::kLong);
+    const std::string snapshot_path = "dataset_bench.fpsnap";
+    simulate_to_snapshot(snapshot_path, rows);
+
+    std::cout << "\n" << rows << " rows x " << features.size(1) << " features, batch " << batch_size << "\n";
+    std::cout << std::setw(22) << "dataset" << std::setw(10) << "workers" << std::setw(16) << "samples/s" << "\n";
+
+    for (size_t workers : {0, 2, 4, 8})
+    {
+        // max_jobs defaults to 2 x workers, i.e. two batches prefetched per worker
+        auto options = torch::data::DataLoaderOptions().batch_size(batch_size).workers(workers);
+
+        auto per_example = torch::data::make_data_loader<torch::data::samplers::RandomSampler>(
+            per_example_dataset(features, targets).map(torch::data::transforms::Stack<>()), options);
+        std::cout << std::setw(22) << "per-example + Stack" << std::setw(10) << workers << std::setw(16)
+                  << drain(per_example) << "\n";
+
+        auto gathered = torch::data::make_data_loader<torch::data::samplers::RandomSampler>(
+            ocid_dataset(features, targets), options);
+        std::cout << std::setw(22) << "ocid_dataset" << std::setw(10) << workers << std::setw(16) << drain(gathered)
+                  << "\n";
+
+        auto mapped = torch::data::make_data_loader<torch::data::samplers::RandomSampler>(
+            ocid_dataset::from_snapshot(snapshot_path), options);
+        std::cout << std::setw(22) << "ocid_dataset (mmap)" << std::setw(10) << workers << std::setw(16)
+                  << drain(mapped) << "\n";
+    }
+
+    std::remove(snapshot_path.c_str());
+    std::cout << "\nDone.\n";
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include <torch/torch.h>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include "unsupervised/decomposition.hpp"
+#include "unsupervised/kmeans.hpp"
+#include "unsupervised/workspace.hpp"
+
+// Previous implementation of one Lloyd iteration: cdist, then one mask/nonzero/index_select per cluster.
+// Kept here only as the baseline the vectorised path is measured against.
+torch::Tensor legacy_iteration(const torch::Tensor &projected, const torch::Tensor &centroids, int K)
+{
+    torch::Tensor labels;
+    auto dists = torch::cdist(projected, centroids);
+    std::tie(std::ignore, labels) = dists.min(1);
+
+    auto new_centroids = torch::zeros_like(centroids);
+    for (int k = 0; k < K; ++k)
+    {
+        auto nz = (labels == k).nonzero().squeeze(1);
+        if (nz.size(0) > 0)
+            new_centroids[k] = projected.index_select(0, nz).mean(0);
+        else
+            new_centroids[k] = centroids[k];
+    }
+    return new_centroids;
+}
+
+template <typename F>
+double time_ms(F &&fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main()
+{
+    std::cout << std::fixed << std::setprecision(3);
+    torch::manual_seed(123);
+
+    const int n_samples = 200000;
+    const int n_dims = 12; // typical number of PCA components kept by pca()
+    const int iters = 10;
+    const int legacy_max_k = 256; // the per-cluster loop becomes impractical beyond this
+
+    auto projected = torch::randn({n_samples, n_dims});
+    std::vector<int> ks = {6, 16, 64, 256, 1024, 4096};
+
+    std::cout << "k-means iteration cost, n=" << n_samples << " d=" << n_dims
+              << " threads=" << torch::get_num_threads() << "\n\n";
+    std::cout << std::setw(8) << "K" << std::setw(16) << "gemm ms/iter" << std::setw(18) << "legacy ms/iter"
+              << std::setw(10) << "speedup" << "\n";
+
+    for (int K : ks)
+    {
+        // Warm-up so allocator and thread pool start-up are not measured
+        kmeans(projected, n_samples, K, 1, 0.0f, false);
+
+        // tol = 0 forces every iteration to run
+        double gemm_ms = time_ms([&] { kmeans(projected, n_samples, K, iters, 0.0f, false); }) / iters;
+
+        std::cout << std::setw(8) << K << std::setw(16) << gemm_ms;
+        if (K <= legacy_max_k)
+        {
+            auto centroids = projected.slice(0, 0, K).clone();
+            double legacy_ms = time_ms([&] {
+                for (int i = 0; i < iters; ++i)
+                    centroids = legacy_iteration(projected, centroids, K);
+            }) / iters;
+            std::cout << std::setw(18) << legacy_ms << std::setw(9) << legacy_ms / gemm_ms << "x";
+        }
+        else
+        {
+            std::cout << std::setw(18) << "-" << std::setw(10) << "-";
+        }
+        std::cout << "\n";
+    }
+
+    // Steady state: once a workspace has been sized, extra iterations allocate nothing.
+    // Two calls differing only in iteration count cancel out the fixed per-call cost.
+    {
+        const int K = 64;
+        workspace ws;
+        kmeans(projected, n_samples, K, 2, 0.0f, false, &ws);
+
+        allocation_counter counter;
+        kmeans(projected, n_samples, K, 1, 0.0f, false, &ws);
+        auto short_run = counter.stats();
+        counter.reset();
+        kmeans(projected, n_samples, K, 1 + iters, 0.0f, false, &ws);
+        auto long_run = counter.stats();
+
+        std::cout << "\nkmeans with workspace, K=" << K << ": " << short_run.allocations << " allocations per call, "
+                  << (double)(long_run.allocations - short_run.allocations) / iters
+                  << " per additional iteration (workspace " << ws.bytes() / (1024.0 * 1024.0) << " MiB)\n";
+    }
+
+    // PCA peak memory on top of the input, against the size of the input itself
+    {
+        auto data = torch::randn({n_samples, 32});
+        const double data_mib = data.numel() * sizeof(float) / (1024.0 * 1024.0);
+        workspace ws;
+        torch::Tensor projected_out;
+
+        allocation_counter counter;
+        pca_fit(data, &projected_out, &ws);
+        auto first = counter.stats();
+        counter.reset();
+        pca_fit(data, &projected_out, &ws);
+        auto second = counter.stats();
+
+        std::cout << "pca_fit on " << data_mib << " MiB: peak extra " << first.peak_bytes / (1024.0 * 1024.0)
+                  << " MiB on the first call, " << second.peak_bytes / (1024.0 * 1024.0)
+                  << " MiB when the workspace and projection are reused\n";
+    }
+
+    std::cout << "\nDone.\n";
+    return 0;
+}
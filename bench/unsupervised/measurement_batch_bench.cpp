@@ -0,0 +1,108 @@
+#include <torch/torch.h>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include <db/access/measurement_batch.hpp>
+#include "unsupervised/measurement_tensors.hpp"
+#include "unsupervised/sparse_fingerprints.hpp"
+
+// Row (std::vector<measurement>) against column (measurement_batch) storage: memory,
+// copy cost, a signal scan, and handing the columns to torch.
+
+template <typename F>
+double time_ms(F &&fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main()
+{
+    std::cout << std::fixed << std::setprecision(2);
+    const size_t n = 2000000;
+    const char *radios[] = {"GSM", "UMTS", "LTE", "NR"};
+
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> lat(40.0, 41.0), lon(-74.5, -73.5);
+    std::uniform_int_distribution<int> cell(1, 5000), signal(-120, -50), pick(0, 3);
+
+    std::vector<measurement> rows(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        auto &m = rows[i];
+        m.key.mcc = 310;
+        m.key.mnc = 260;
+        m.key.lac = 1 + cell(rng) % 40;
+        m.key.cellid = cell(rng);
+        m.key.measured_at = 1700000000000 + (int64_t)i;
+        m.core_data.lat = lat(rng);
+        m.core_data.lon = lon(rng);
+        m.radio = radios[pick(rng)];
+        m.apikey = "test-key";
+        if (i % 4 != 0)
+            m.movement_data.signal = signal(rng);
+    }
+
+    measurement_batch batch;
+    double convert_ms = time_ms([&] { batch = measurement_batch::from_rows(rows); });
+
+    std::cout << "rows=" << n << "  sizeof(measurement)=" << sizeof(measurement) << " bytes\n\n";
+
+    std::vector<measurement> row_copy;
+    measurement_batch batch_copy;
+    std::cout << "copy   AoS " << time_ms([&] { row_copy = rows; }) << " ms"
+              << "   SoA " << time_ms([&] { batch_copy = batch; }) << " ms\n";
+
+    // Mean of the present signal values
+    double aos_mean = 0, soa_mean = 0, tensor_mean = 0;
+    double aos_ms = time_ms([&] {
+        int64_t sum = 0, count = 0;
+        for (const auto &m : rows)
+        {
+            if (m.movement_data.signal != 0)
+            {
+                sum += m.movement_data.signal;
+                ++count;
+            }
+        }
+        aos_mean = (double)sum / count;
+    });
+    double soa_ms = time_ms([&] {
+        int64_t sum = 0;
+        for (int32_t v : batch.signal.values)
+            sum += v; // nulls hold 0
+        soa_mean = (double)sum / batch.signal.validity.count();
+    });
+    double tensor_ms = time_ms([&] {
+        auto values = column_tensor(batch.signal);
+        auto mask = validity_mask(batch.signal);
+        tensor_mean = values.masked_select(mask).to(torch::kDouble).mean().item<double>();
+    });
+    std::cout << "scan   AoS " << aos_ms << " ms   SoA " << soa_ms << " ms   tensor view " << tensor_ms
+              << " ms   (mean signal " << aos_mean << " / " << soa_mean << " / " << tensor_mean << ")\n";
+
+    std::cout << "from_rows " << convert_ms << " ms, radio dictionary " << batch.radio.dictionary.size()
+              << " entries\n";
+
+    // The tensor aliases the column: no copy
+    auto lat_view = column_tensor(batch.lat);
+    std::cout << "lat view shares memory: " << std::boolalpha
+              << (lat_view.data_ptr<double>() == batch.lat.values.data()) << "\n";
+
+    double fp_rows = time_ms([&] {
+        sparse_fingerprint_builder builder;
+        builder.add(rows);
+    });
+    double fp_batch = time_ms([&] {
+        sparse_fingerprint_builder builder;
+        builder.add(batch);
+    });
+    std::cout << "\nsparse_fingerprint_builder::add   rows " << fp_rows << " ms   batch " << fp_batch << " ms\n";
+
+    std::cout << "\nDone.\n";
+    return 0;
+}
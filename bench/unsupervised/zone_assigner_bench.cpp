@@ -0,0 +1,79 @@
+#include <torch/torch.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+#include "unsupervised/simulator.hpp"
+#include "unsupervised/decomposition.hpp"
+#include "unsupervised/kmeans.hpp"
+#include "unsupervised/zone_assigner.hpp"
+
+// Closed-loop load generator: every client thread submits one fingerprint,
+// waits for its zone and immediately submits the next.
+void run_load(zone_assigner &assigner, const torch::Tensor &fingerprints, int n_clients, int64_t per_client)
+{
+    std::vector<std::thread> clients;
+    for (int c = 0; c < n_clients; ++c)
+    {
+        clients.emplace_back([&, c] {
+            const int64_t n = fingerprints.size(0), f = fingerprints.size(1);
+            const float *data = fingerprints.data_ptr<float>();
+            for (int64_t i = 0; i < per_client; ++i)
+            {
+                int64_t row = (c * per_client + i) % n;
+                assigner.assign(std::vector<float>(data + row * f, data + (row + 1) * f));
+            }
+        });
+    }
+    for (auto &t : clients)
+        t.join();
+}
+
+int main()
+{
+    std::cout << std::fixed << std::setprecision(2);
+    torch::manual_seed(123);
+
+    // Fit a zone model once and round-trip it through a file, like production does
+    const int n_samples = 20000, n_features = 32, K = 64;
+    auto data = sampleSimulator(n_samples, n_features);
+    torch::Tensor projected;
+    auto model = pca_fit(data, &projected);
+    kmeans_options km(K);
+    km.seed = 123;
+    auto fit = kmeans_fit(projected, km);
+
+    const std::string model_path = "zone_model_bench.pt";
+    save_zone_model(model_path, model, fit.centroids);
+
+    auto fingerprints = data.to(torch::kFloat).contiguous();
+    const int64_t per_client = 5000;
+
+    std::cout << "\nZone assignment load test, F=" << n_features << " K=" << K << "\n\n";
+    std::cout << std::setw(10) << "window us" << std::setw(9) << "clients" << std::setw(12) << "req/s"
+              << std::setw(12) << "avg batch" << std::setw(10) << "mean us" << std::setw(10) << "p50 us"
+              << std::setw(10) << "p99 us" << std::setw(10) << "max us" << "\n";
+
+    for (int window_us : {0, 50, 200})
+    {
+        for (int n_clients : {1, 8, 64})
+        {
+            zone_assigner_options options;
+            options.window = std::chrono::microseconds(window_us);
+            auto assigner = zone_assigner::load(model_path, options);
+
+            run_load(*assigner, fingerprints, n_clients, per_client);
+            auto s = assigner->stats();
+
+            std::cout << std::setw(10) << window_us << std::setw(9) << n_clients << std::setw(12)
+                      << s.requests_per_second << std::setw(12) << s.mean_batch_size << std::setw(10)
+                      << s.mean_latency_us << std::setw(10) << s.p50_latency_us << std::setw(10)
+                      << s.p99_latency_us << std::setw(10) << s.max_latency_us << "\n";
+        }
+    }
+
+    std::cout << "\nDone.\n";
+    return 0;
+}
@@ -8,7 +8,9 @@
 #define LIBTORCH_VERSION "2.5.0"
 #define SCRIPTS_MODLES_PATH "/home/lsmon/Documents/libtorch_cpp/scripts/models"
 #define MODEL_RESNET18 "/home/lsmon/Documents/libtorch_cpp/models/resnet18_scriptmodule.pt"
+#define MODEL_RESNET18_INT8 "/home/lsmon/Documents/libtorch_cpp/models/resnet18_int8_scriptmodule.pt"
 #define MODEL_SAVE_PATH "/home/lsmon/Documents/libtorch_cpp/models/output/model.pt"
+#define ZONE_MODEL_PATH "/home/lsmon/Documents/libtorch_cpp/models/output/zone_model.pt"
 
 
 // You can even pass paths
@@ -0,0 +1,179 @@
+#ifndef CELL_ROLLUP_HPP
+#define CELL_ROLLUP_HPP
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <db/connector.hpp>
+#include <db/access/measurement.hpp>
+#include <db/access/measurement_batch.hpp>
+
+// Mergeable quantile sketch with relative accuracy (DDSketch): values fall into
+// logarithmic bins, so any quantile is returned within 'relative_accuracy' of the true
+// value and two sketches merge by adding bin counts. Size grows with the log of the
+// value range, not with the number of values (about 100 bins for -140..-20 dBm at 1%).
+class quantile_sketch
+{
+private:
+    double accuracy, gamma, log_gamma;
+    std::map<int32_t, uint64_t> positive, negative; // bin index → count; negative holds |x|
+    uint64_t zeros, n;
+
+    int32_t bin_of(double magnitude) const;
+
+    double value_of(int32_t bin) const;
+
+public:
+    explicit quantile_sketch(double relative_accuracy = 0.01);
+
+    void add(double value);
+
+    // Both sketches must have the same accuracy.
+    void merge(const quantile_sketch &other);
+
+    // Value at quantile q in [0, 1]; NaN when empty.
+    double quantile(double q) const;
+
+    uint64_t count() const { return n; }
+
+    double relative_accuracy() const { return accuracy; }
+
+    // Compact binary form for the rollup table's blob column.
+    std::string serialize() const;
+
+    static quantile_sketch deserialize(const std::string &bytes);
+};
+
+// Rollup of the measurements of one cell, over its whole history or one time bucket.
+struct rollup_aggregate {
+    int64_t samples;
+    // Signal statistics cover only the rows that reported a signal
+    int64_t signal_count;
+    double signal_sum, signal_min, signal_max;
+    // Range of measured_at seen (ms)
+    int64_t first_seen, last_seen;
+    quantile_sketch signal_sketch;
+
+    explicit rollup_aggregate(double sketch_accuracy = 0.01)
+        : samples(0), signal_count(0), signal_sum(0), signal_min(0), signal_max(0), first_seen(0), last_seen(0),
+          signal_sketch(sketch_accuracy) {}
+
+    void add(int64_t measured_at, bool has_signal, int32_t signal);
+
+    void merge(const rollup_aggregate &other);
+
+    // 0 when no signal was reported, as in the stats struct
+    double avg_signal() const { return signal_count ? signal_sum / signal_count : 0; }
+};
+
+// A cell and the start of a time bucket (ms).
+struct rollup_key {
+    int32_t mcc, mnc, lac;
+    int64_t cellid, bucket_start;
+
+    rollup_key() : mcc(0), mnc(0), lac(0), cellid(0), bucket_start(0) {}
+
+    bool operator==(const rollup_key &o) const
+    {
+        return cellid == o.cellid && bucket_start == o.bucket_start && lac == o.lac && mnc == o.mnc && mcc == o.mcc;
+    }
+};
+
+struct rollup_options {
+    // Width of a time bucket (default one hour)
+    int64_t bucket_ms;
+    // Each rollup map is split into this many independently locked shards
+    int n_shards;
+    double sketch_accuracy;
+    // Writes in flight at once during flush()
+    size_t max_in_flight;
+    // Identifies the input being aggregated (e.g. a hash of the imported files). When set,
+    // the n-th flush that writes new deltas gets a flush_id derived from (source_id, n), so
+    // running the same import again overwrites its rollup rows instead of adding to them.
+    // 0 draws a random flush_id per flush, for live ingest.
+    uint64_t source_id;
+
+    rollup_options()
+        : bucket_ms(3600000), n_shards(64), sketch_accuracy(0.01), max_in_flight(256), source_id(0) {}
+};
+
+// Ingest-side aggregator: keeps per-(cell, time bucket) rollups in memory as rows arrive
+// and flushes them to the cell_rollups table, so dashboards read a few rows per cell
+// instead of scanning raw measurements.
+//
+// Each flush writes the bucket deltas accumulated since the previous one under a fresh
+// flush_id (see rollup_options::source_id) and clears them; readers merge the rows of a bucket (load() does this). A row
+// whose write failed is retried unchanged under its original flush_id. Memory is bounded
+// by the cells seen since the last flush; whole-history rollups are derived from the
+// stored buckets (load_cell()). The table is created by schema::create (db/schema.hpp).
+class rollup_aggregator
+{
+private:
+    struct key_hash {
+        size_t operator()(const rollup_key &k) const;
+    };
+
+    using rollup_map = std::unordered_map<rollup_key, rollup_aggregate, key_hash>;
+
+    struct shard {
+        mutable std::mutex lock;
+        rollup_map buckets;
+    };
+
+    // A bucket delta under the flush_id it was first written with
+    struct written_row {
+        rollup_key key;
+        rollup_aggregate aggregate;
+        int64_t flush_id;
+    };
+
+    rollup_options options;
+    std::vector<shard> shards;
+
+    // Rows whose write failed; rewritten unchanged under the same flush_id, so a write that
+    // did reach the cluster is overwritten rather than counted twice
+    mutable std::mutex retry_lock;
+    std::vector<written_row> retry;
+    // Flushes that wrote new deltas so far; guarded by retry_lock
+    uint64_t flushes;
+
+    size_t shard_of(const rollup_key &key) const;
+
+    int64_t bucket_of(int64_t measured_at) const;
+
+    void merge_local(std::vector<rollup_map> &buckets);
+
+public:
+    explicit rollup_aggregator(rollup_options options = rollup_options());
+
+    // Thread-safe. The signal statistics take the row's signal, or its avg_signal when it
+    // has none (OpenCellID exports only carry avg_signal). Zero means absent, as everywhere
+    // in measurement.
+    void add(const measurement &m);
+
+    // Pre-aggregates the batch locally, then takes every shard lock at most once.
+    void add(const measurement_batch &batch);
+
+    // Copies of the bucket rollups not flushed yet, rows awaiting a retry included.
+    std::vector<std::pair<rollup_key, rollup_aggregate>> pending_buckets() const;
+
+    // Writes the pending bucket rollups and returns how many rows were written. Rows that
+    // fail to write are kept, with their flush_id, for the next flush, then the first
+    // error is thrown.
+    size_t flush(connector &db);
+
+    // Bucket rollups of one cell with bucket_start in [from_ms, to_ms), one per bucket
+    // with the rows of every flush merged, ordered by bucket_start.
+    static std::vector<std::pair<int64_t, rollup_aggregate>> load(connector &db, int32_t mcc, int32_t mnc,
+                                                                  int32_t lac, int64_t cellid, int64_t from_ms,
+                                                                  int64_t to_ms);
+
+    // Whole-history rollup of a cell: every stored bucket merged; empty if never flushed.
+    static rollup_aggregate load_cell(connector &db, int32_t mcc, int32_t mnc, int32_t lac, int64_t cellid);
+};
+
+#endif // CELL_ROLLUP_HPP
@@ -4,7 +4,13 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <tuple>
+#include <unordered_map>
 #include <db/connector.hpp>
+#include <db/schema.hpp>
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
@@ -37,6 +43,9 @@ struct column_names {
     const char *avg_signal = "avg_signal";
     const char *created_at = "created_at";
     const char *updated_at = "updated_at";
+    // Bucketed layout only (db/schema.hpp)
+    const char *lac_bucket = "lac_bucket";
+    const char *day = "day";
 };
 
 const column_names columns;
@@ -46,6 +55,11 @@ struct keys {
     int64_t cellid, measured_at;
 
     keys() : mcc(0), mnc(0), lac(0), cellid(0), measured_at(0) {}
+
+    bool operator==(const keys &o) const
+    {
+        return measured_at == o.measured_at && cellid == o.cellid && lac == o.lac && mnc == o.mnc && mcc == o.mcc;
+    }
 };
 
 struct core {
@@ -104,6 +118,14 @@ struct measurement {
     measurement() : radio(""), apikey(""), devn("") {}
 };
 
+// New signal value of one measurement row
+struct signal_update {
+    keys key;
+    int32_t signal;
+
+    signal_update() : signal(0) {}
+};
+
 class json_helper
 {
 public:
@@ -123,24 +145,123 @@ public:
 };
 
 
+// db/access/measurement_batch.hpp
+struct measurement_batch;
+struct measurement_range;
+struct measurement_page;
+class rollup_aggregator;  // db/access/cell_rollup.hpp
+
 class measurement_manager : public json_helper {
 private:
     // Database connection and session would be members here
     connector& db;
+    // Optional ingest-side rollups, fed with every successfully inserted row
+    rollup_aggregator* rollups;
+
+    // Prepared statements by CQL text, prepared on first use and kept for the manager's lifetime.
+    // The lock only guards the map; preparing happens outside it.
+    std::mutex prepared_lock;
+    std::unordered_map<std::string, const CassPrepared*> prepared_statements;
+
+    const CassPrepared* prepared(const std::string& cql);
+
+    measurement_layout layout;
+
+    // (mcc, mnc, lac_bucket, day) of the buckets already recorded in measurement_buckets
+    using bucket_id = std::tuple<int32_t, int32_t, int32_t, int64_t>;
+    std::mutex bucket_lock;
+    std::set<bucket_id> known_buckets;
+
+    // Adds the buckets not recorded yet to measurement_buckets
+    void record_buckets(const std::vector<bucket_id>& buckets);
+
+    // (lac_bucket, day) of every non-empty bucket of an operator
+    std::vector<std::pair<int32_t, int64_t>> operator_buckets(int32_t mcc, int32_t mnc);
+
+    // WHERE clause matching one row, with the bucket columns in the bucketed layout
+    std::string row_clause() const;
+
+    void bind_bucket(CassStatement* statement, int32_t lac, int64_t measured_at) const;
+
+    // Bound range query over the table of the layout ('day' is ignored unless bucketed),
+    // with the given remaining limit and resume token; the caller frees it
+    CassStatement* range_statement(const measurement_range& range, int64_t day, int32_t limit,
+                                   const std::string& paging_token);
+
+    // Days of the range holding rows of the cell's bucket, in the order of the range,
+    // starting at 'from_day' (when resuming)
+    std::vector<int64_t> range_days(const measurement_range& range, const int64_t* from_day);
+
+    measurement_page get_bucketed_range(const measurement_range& range);
+
+    size_t scan_bucketed_range(const measurement_range& range,
+                               const std::function<void(const measurement_batch&)>& consume);
 public:
-    measurement_manager(connector& db_conn) : db(db_conn) {}
+    measurement_manager(connector& db_conn, rollup_aggregator* rollups = nullptr,
+                        measurement_layout layout = measurement_layout())
+        : db(db_conn), rollups(rollups), layout(layout) {}
+
+    ~measurement_manager();
+
+    measurement_manager(const measurement_manager&) = delete;
+    measurement_manager& operator=(const measurement_manager&) = delete;
 
     void insert(const measurement& m);
 
+    // Inserts every row of the batch, binding straight from its columns; null values are
+    // left out of the row. Statements are prepared once per distinct set of non-null
+    // columns and executed asynchronously. Throws on the first failed row; the rollups
+    // only see the batch when every row was written.
+    void insert(const measurement_batch& batch);
+
     measurement get_measurement(int32_t mcc, int32_t mnc, int32_t lac, int32_t cellid, int64_t ts);
 
     std::vector<measurement> get_measurements(int32_t mcc, int32_t mnc);
 
+    // One measurement per key, in input order (a default measurement where there is no
+    // row). All lookups go out as async prepared statements, at most 'concurrency' at once,
+    // so n keys cost about n / concurrency round trips. Throws if any lookup fails.
+    std::vector<measurement> get_measurements(const std::vector<keys>& lookups, size_t concurrency = 256);
+
+    // Every row of the operator, all pages, decoded column by column into a batch, ordered
+    // by (lac, cellid, measured_at). In the bucketed layout the buckets are read
+    // concurrently and merged.
+    measurement_batch get_measurement_batch(int32_t mcc, int32_t mnc);
+
+    // Streams every row of the operator to 'consume' without holding it all in memory, one
+    // batch per page. In the bucketed layout the buckets are read concurrently and their
+    // pages delivered in (lac_bucket, day) order, each bucket in clustering order. Returns
+    // the number of rows.
+    size_t scan_measurements(int32_t mcc, int32_t mnc,
+                             const std::function<void(const measurement_batch&)>& consume);
+
+    // One page of a cell's time range, selecting only the requested columns. Pass the
+    // returned paging_state back in the range to fetch the next page.
+    measurement_page get_measurement_range(const measurement_range& range);
+
+    // Streams every page of the range (from range.paging_state on) to 'consume', one batch
+    // per round trip. In the bucketed layout the days of the range are read concurrently
+    // and their pages delivered in day order. Returns the number of rows delivered.
+    size_t scan_measurement_range(const measurement_range& range,
+                                  const std::function<void(const measurement_batch&)>& consume);
+
     void update_signal(int32_t mcc, int32_t mnc, int32_t lac, int32_t cellid, int64_t ts, int32_t new_signal);
 
+    // Writes the updates asynchronously, grouped by partition into unlogged batches (one
+    // partition per batch, so each is applied by a single replica set). The updates of
+    // failed batches are appended to 'failed' (if given) and the first error is thrown once
+    // every write has finished. Returns the number of batches sent.
+    size_t update_signals(const std::vector<signal_update>& updates, std::vector<signal_update>* failed = nullptr);
+
     void remove(int32_t mcc, int32_t mnc, int32_t lac, int32_t cellid, int64_t ts);
 
-    core get_tower_location(int32_t mcc, int32_t mnc, int32_t lac, int32_t cellid);  
+    core get_tower_location(int32_t mcc, int32_t mnc, int32_t lac, int64_t cellid);  
+
+    // get_tower_location for every cell (measured_at is ignored), in input order and with
+    // the lookups in flight together as in get_measurements(lookups). In the bucketed layout
+    // the days of every distinct (mcc, mnc, lac_bucket) are read first, concurrently, then
+    // each cell queries its days oldest first, 8 per query, until one holds it.
+    std::vector<core> get_tower_locations(const std::vector<keys>& cells, size_t concurrency = 256);
 };
 
 #endif // MEASUREMENT_HPP
\ No newline at end of file
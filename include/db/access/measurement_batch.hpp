@@ -0,0 +1,216 @@
+#ifndef MEASUREMENT_BATCH_HPP
+#define MEASUREMENT_BATCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <db/access/measurement.hpp>
+
+// One bit per row, set when the row holds a value.
+class validity_bitmap
+{
+private:
+    std::vector<uint64_t> words;
+    size_t n;
+
+public:
+    validity_bitmap() : n(0) {}
+
+    void push_back(bool valid)
+    {
+        if (n % 64 == 0)
+            words.push_back(0);
+        if (valid)
+            words.back() |= uint64_t(1) << (n % 64);
+        ++n;
+    }
+
+    bool get(size_t i) const { return (words[i / 64] >> (i % 64)) & 1; }
+
+    void set(size_t i, bool valid)
+    {
+        if (valid)
+            words[i / 64] |= uint64_t(1) << (i % 64);
+        else
+            words[i / 64] &= ~(uint64_t(1) << (i % 64));
+    }
+
+    size_t size() const { return n; }
+
+    // Number of valid rows.
+    size_t count() const;
+
+    const uint64_t *data() const { return words.data(); }
+
+    void reserve(size_t rows) { words.reserve((rows + 63) / 64); }
+
+    void clear()
+    {
+        words.clear();
+        n = 0;
+    }
+};
+
+// A contiguous typed array plus its validity bitmap. Invalid rows hold T().
+template <typename T>
+struct column {
+    std::vector<T> values;
+    validity_bitmap validity;
+
+    void push_back(T value)
+    {
+        values.push_back(value);
+        validity.push_back(true);
+    }
+
+    void push_null()
+    {
+        values.push_back(T());
+        validity.push_back(false);
+    }
+
+    bool valid(size_t i) const { return validity.get(i); }
+
+    size_t size() const { return values.size(); }
+
+    void reserve(size_t rows)
+    {
+        values.reserve(rows);
+        validity.reserve(rows);
+    }
+
+    void clear()
+    {
+        values.clear();
+        validity.clear();
+    }
+};
+
+// Distinct strings numbered in order of first appearance.
+class string_dictionary
+{
+private:
+    std::vector<std::string> values;
+    std::unordered_map<std::string, int32_t> index;
+
+public:
+    int32_t encode(const std::string &value);
+
+    // Code of 'value', or -1 when it has never been encoded.
+    int32_t find(const std::string &value) const;
+
+    const std::string &decode(int32_t code) const { return values[code]; }
+
+    size_t size() const { return values.size(); }
+
+    void clear()
+    {
+        values.clear();
+        index.clear();
+    }
+};
+
+// A string column stored as int32 codes into a dictionary.
+struct dictionary_column {
+    column<int32_t> codes;
+    string_dictionary dictionary;
+
+    void push_back(const std::string &value) { codes.push_back(dictionary.encode(value)); }
+
+    void push_null() { codes.push_null(); }
+
+    bool valid(size_t i) const { return codes.valid(i); }
+
+    // The row's string; empty for a null row.
+    const std::string &at(size_t i) const;
+
+    size_t size() const { return codes.size(); }
+};
+
+// Column-oriented (SoA) batch of measurements: one contiguous array per field, string
+// fields dictionary-encoded, and an explicit validity bit per value instead of the
+// "0 means absent" convention of measurement. Key columns are always valid.
+//
+// The numeric arrays are plain std::vectors, so parsers append to them directly, the
+// access layer binds from them and ML code views them as tensors without copying
+// (see unsupervised/measurement_tensors.hpp).
+struct measurement_batch {
+    // PK
+    std::vector<int32_t> mcc, mnc, lac;
+    std::vector<int64_t> cellid, measured_at;
+
+    // Core
+    column<double> lat, lon, rating;
+    column<int32_t> range;
+
+    // Strings
+    dictionary_column radio, apikey, devn;
+
+    // Stats
+    column<int32_t> unit, samples, changeable, avg_signal;
+    column<int64_t> created_at, updated_at;
+
+    // Signal/Movement
+    column<int32_t> signal;
+    column<double> speed, direction;
+
+    // Tech Specific
+    column<int32_t> ta, tac, pci, sid, nid, bid;
+
+    size_t size() const { return mcc.size(); }
+
+    bool empty() const { return mcc.empty(); }
+
+    void reserve(size_t rows);
+
+    void clear();
+
+    // Appends a row; zero numbers and empty strings become nulls, as measurement cannot
+    // tell them apart.
+    void append(const measurement &m);
+
+    // Appends row 'i' of another batch, nulls included.
+    void append(const measurement_batch &other, size_t i);
+
+    // Row 'i' as a measurement; nulls become 0 or "".
+    measurement row(size_t i) const;
+
+    static measurement_batch from_rows(const std::vector<measurement> &rows);
+
+    std::vector<measurement> to_rows() const;
+};
+
+// Rows of one cell with measured_at in [start_ms, end_ms), served page by page from the
+// (lac, cellid, measured_at) clustering key, so the cost follows the result size rather
+// than the size of the (mcc, mnc) partition.
+struct measurement_range {
+    int32_t mcc, mnc, lac;
+    int64_t cellid;
+    int64_t start_ms, end_ms;
+    // At most this many rows over all pages (0 = no limit)
+    int32_t limit;
+    // Newest first
+    bool descending;
+    // Rows per round trip
+    int32_t page_size;
+    // Columns fetched besides the key columns, named as in column_names; empty = all.
+    // Columns not fetched come back null.
+    std::vector<std::string> fields;
+    // Resume point: paging_state of the previous measurement_page; empty for the first page
+    std::string paging_state;
+
+    measurement_range()
+        : mcc(0), mnc(0), lac(0), cellid(0), start_ms(0), end_ms(0), limit(0), descending(false), page_size(5000) {}
+};
+
+struct measurement_page {
+    measurement_batch rows;
+    // Opaque token for the next page, to pass back in measurement_range; empty on the last page
+    std::string paging_state;
+
+    bool has_more() const { return !paging_state.empty(); }
+};
+
+#endif // MEASUREMENT_BATCH_HPP
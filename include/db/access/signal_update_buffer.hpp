@@ -0,0 +1,97 @@
+#ifndef SIGNAL_UPDATE_BUFFER_HPP
+#define SIGNAL_UPDATE_BUFFER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <db/access/measurement.hpp>
+
+struct signal_buffer_options {
+    // Flush as soon as this many distinct rows are pending
+    size_t max_pending;
+    // Flush once the oldest pending update has waited this long (ms)
+    int64_t max_delay_ms;
+
+    signal_buffer_options() : max_pending(10000), max_delay_ms(1000) {}
+};
+
+struct signal_buffer_stats {
+    // update() calls accepted
+    uint64_t updates;
+    // Rows written to the cluster
+    uint64_t writes;
+    uint64_t flushes, failed_flushes;
+
+    signal_buffer_stats() : updates(0), writes(0), flushes(0), failed_flushes(0) {}
+
+    // Updates per written row; 1 means nothing was coalesced
+    double collapse_ratio() const { return writes ? (double)updates / writes : 0; }
+};
+
+// Coalescing front end for measurement_manager::update_signal. Updates are kept in a map
+// keyed by primary key, so a row updated many times between flushes is written once with
+// its latest value. The map is flushed through measurement_manager::update_signals when it
+// reaches max_pending rows (by the caller of update(), which gives back-pressure) or when
+// its oldest update is max_delay_ms old (by a background thread).
+//
+// A failed flush keeps its rows pending unless a newer value has arrived meanwhile, so
+// the final state is not lost. flush(), shutdown() and an update() that triggers a flush
+// rethrow the error; the background thread reports it on std::cerr and retries
+// max_delay_ms later.
+class signal_update_buffer
+{
+private:
+    struct key_hash {
+        size_t operator()(const keys &k) const;
+    };
+
+    using update_map = std::unordered_map<keys, int32_t, key_hash>;
+
+    measurement_manager &manager;
+    signal_buffer_options options;
+
+    mutable std::mutex lock;
+    std::condition_variable wake;
+    update_map pending;
+    std::chrono::steady_clock::time_point oldest;
+    bool stopping;
+
+    // One flush at a time, so an older value can never overwrite a newer one
+    std::mutex flush_lock;
+
+    std::atomic<uint64_t> updates, writes, flushes, failed_flushes;
+
+    std::thread flusher;
+
+    void run();
+
+public:
+    explicit signal_update_buffer(measurement_manager &manager,
+                                  signal_buffer_options options = signal_buffer_options());
+
+    // Calls shutdown(); an error from the final flush is reported on std::cerr.
+    ~signal_update_buffer();
+
+    signal_update_buffer(const signal_update_buffer &) = delete;
+    signal_update_buffer &operator=(const signal_update_buffer &) = delete;
+
+    // Same arguments as measurement_manager::update_signal. Thread-safe. Throws after shutdown().
+    void update(int32_t mcc, int32_t mnc, int32_t lac, int64_t cellid, int64_t ts, int32_t new_signal);
+
+    // Writes everything pending now and returns the number of rows written.
+    size_t flush();
+
+    // Stops the background thread and flushes what is left. Idempotent.
+    void shutdown();
+
+    size_t pending_rows() const;
+
+    signal_buffer_stats stats() const;
+};
+
+#endif // SIGNAL_UPDATE_BUFFER_HPP
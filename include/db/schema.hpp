@@ -0,0 +1,52 @@
+#ifndef SCHEMA_HPP
+#define SCHEMA_HPP
+
+#include <cstdint>
+#include <string>
+#include <db/connector.hpp>
+
+// How measurement rows are partitioned.
+//
+// Default: one partition per operator, ((mcc, mnc), lac, cellid, measured_at) in the
+// measurements table. Large operators end up as one huge partition on one token.
+//
+// Bucketed: ((mcc, mnc, lac_bucket, day), lac, cellid, measured_at) in the
+// measurements_by_bucket table, with lac_bucket = lac mod lac_buckets and
+// day = floor(measured_at / day_ms). An operator is spread over lac_buckets partitions
+// per day. The measurement_buckets table lists the non-empty buckets of each operator so
+// that reads know which partitions to query.
+struct measurement_layout {
+    bool bucketed;
+    int32_t lac_buckets;
+    int64_t day_ms;
+
+    measurement_layout() : bucketed(false), lac_buckets(16), day_ms(86400000) {}
+
+    static measurement_layout by_bucket(int32_t lac_buckets = 16, int64_t day_ms = 86400000);
+
+    const char *table() const { return bucketed ? "measurements_by_bucket" : "measurements"; }
+
+    int32_t lac_bucket(int32_t lac) const;
+
+    int64_t day(int64_t measured_at) const;
+};
+
+struct schema_options {
+    std::string keyspace;
+    int replication_factor;
+    measurement_layout layout;
+
+    schema_options() : keyspace("open_cell_id"), replication_factor(1) {}
+};
+
+// The tables this project reads and writes, created in one place.
+class schema
+{
+public:
+    // Creates the keyspace, the measurements table, the cell_rollups table and, for a
+    // bucketed layout, measurements_by_bucket and measurement_buckets. Existing tables are
+    // left as they are. The keyspace becomes the session's keyspace.
+    static void create(connector &db, const schema_options &options = schema_options());
+};
+
+#endif // SCHEMA_HPP
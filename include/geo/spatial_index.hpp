@@ -0,0 +1,84 @@
+#ifndef SPATIAL_INDEX_HPP
+#define SPATIAL_INDEX_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <db/access/measurement.hpp>
+
+// In-memory lat/lon grid over tower or measurement locations.
+//
+// The globe is cut into square cells of 'cell_degrees'; a cell id is row-major
+// (lat_row * columns + lon_col), so each latitude row of a query box is one contiguous
+// id range. Entries are stored structure-of-arrays, sorted by cell id, and a query is a
+// binary search per row followed by a linear scan over packed lat/lon arrays.
+class spatial_index
+{
+private:
+    double cell_deg;
+    int64_t columns, rows;
+
+    // Sorted by cell id; index i refers to the same entry in every array
+    std::vector<uint64_t> cell_ids;
+    std::vector<double> lats, lons;
+    std::vector<keys> entry_keys;
+    std::vector<core> entry_cores;
+
+    int64_t row_of(double lat) const;
+
+    int64_t col_of(double lon) const;
+
+public:
+    explicit spatial_index(double cell_degrees = 0.01);
+
+    // Bulk build from a scan or snapshot. Rows without a location (lat and lon both 0)
+    // are skipped. Cell ids are computed and sorted on 'n_threads' threads (0 = all cores).
+    void build(const std::vector<measurement> &records, unsigned n_threads = 0);
+
+    void build(const std::vector<keys> &ks, const std::vector<core> &locations, unsigned n_threads = 0);
+
+    // Calls fn(i) for every entry inside the box. A box with min_lon > max_lon wraps the antimeridian.
+    template <typename F>
+    void for_each_in_box(double min_lat, double min_lon, double max_lat, double max_lon, F &&fn) const;
+
+    std::vector<size_t> within_box(double min_lat, double min_lon, double max_lat, double max_lon) const;
+
+    // Entries within 'radius_m' metres (great-circle distance) of lat/lon.
+    std::vector<size_t> within_radius(double lat, double lon, double radius_m) const;
+
+    size_t size() const { return lats.size(); }
+
+    const keys &key(size_t i) const { return entry_keys[i]; }
+
+    const core &location(size_t i) const { return entry_cores[i]; }
+
+    static double haversine_m(double lat1, double lon1, double lat2, double lon2);
+};
+
+template <typename F>
+void spatial_index::for_each_in_box(double min_lat, double min_lon, double max_lat, double max_lon, F &&fn) const
+{
+    if (min_lon > max_lon)
+    {
+        for_each_in_box(min_lat, min_lon, max_lat, 180.0, fn);
+        for_each_in_box(min_lat, -180.0, max_lat, max_lon, fn);
+        return;
+    }
+
+    const int64_t first_col = col_of(min_lon), last_col = col_of(max_lon);
+    for (int64_t row = row_of(min_lat); row <= row_of(max_lat); ++row)
+    {
+        const uint64_t lo = (uint64_t)(row * columns + first_col);
+        const uint64_t hi = (uint64_t)(row * columns + last_col);
+        auto it = std::lower_bound(cell_ids.begin(), cell_ids.end(), lo);
+        for (size_t i = it - cell_ids.begin(); i < cell_ids.size() && cell_ids[i] <= hi; ++i)
+        {
+            // Edge cells are only partly inside the box
+            if (lats[i] >= min_lat && lats[i] <= max_lat && lons[i] >= min_lon && lons[i] <= max_lon)
+                fn(i);
+        }
+    }
+}
+
+#endif // SPATIAL_INDEX_HPP
@@ -0,0 +1,99 @@
+#ifndef INFERENCE_ENGINE_HPP
+#define INFERENCE_ENGINE_HPP
+
+#include <torch/torch.h>
+#include <torch/script.h>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <serving/micro_batcher.hpp>
+
+struct inference_engine_options {
+    // Shape of one example without the batch dimension, e.g. {3, 224, 224}; used for warm-up
+    std::vector<int64_t> example_shape;
+    // Worker threads, each running its own clone of the module
+    int replicas;
+    // Process-wide intra-op threads (libtorch has one pool); 0 = hardware threads / replicas
+    int intra_op_threads;
+    // How long the first request of a batch waits for others to join it
+    std::chrono::microseconds window;
+    // A batch is dispatched as soon as it reaches this many requests
+    int64_t max_batch;
+    // Forward passes per replica and per warm-up batch size before serving
+    int warmup_runs;
+    // Freeze the module and run optimize_for_inference (conv-bn folding, op fusion, MKLDNN)
+    bool optimize;
+    // Run 4-D inputs and conv weights in NHWC (channels-last) memory format
+    bool channels_last;
+
+    inference_engine_options()
+        : example_shape({3, 224, 224}), replicas(1), intra_op_threads(0), window(2000), max_batch(16),
+          warmup_runs(3), optimize(true), channels_last(false) {}
+};
+
+// requests_per_second counts from the end of the warm-up, i.e. images/s for an image model
+using inference_stats = serving_stats;
+
+// Serves a TorchScript module on CPU. Requests are single examples; replica threads pull
+// micro-batches off one shared queue, stack them and run forward under InferenceMode.
+// Each request's future yields its row of the batch output.
+//
+// The engine works on a clone of the module it is given, which is left untouched.
+class inference_engine
+{
+private:
+    struct request {
+        torch::Tensor example;
+        std::promise<torch::Tensor> output;
+        std::chrono::steady_clock::time_point submitted;
+    };
+
+    inference_engine_options options;
+    std::vector<torch::jit::Module> modules;
+
+    micro_batcher<request> queue;
+    latency_recorder latencies;
+
+    std::vector<std::thread> workers;
+
+    void worker_loop(size_t replica);
+
+    void run_batch(torch::jit::Module &module, std::vector<request> &batch);
+
+    torch::Tensor prepare_input(torch::Tensor batch) const;
+
+public:
+    inference_engine(torch::jit::Module module, inference_engine_options options = inference_engine_options());
+
+    static std::unique_ptr<inference_engine> load(const std::string &path,
+                                                  inference_engine_options options = inference_engine_options());
+
+    // Prepares a module for serving: eval(), then freeze + optimize_for_inference.
+    // Int8 modules (quantized TorchScript from create_restnet18.py --int8) go through the
+    // same path; their quantized ops are left as they are.
+    static torch::jit::Module optimize_module(torch::jit::Module module);
+
+    // Converts the 4-D float parameters to channels-last in place, before freezing bakes
+    // them in. Modules share parameters with their copies, so clone() one that is in use.
+    static void to_channels_last(torch::jit::Module &module);
+
+    // Drains the pending requests, then stops the workers.
+    ~inference_engine();
+
+    inference_engine(const inference_engine &) = delete;
+    inference_engine &operator=(const inference_engine &) = delete;
+
+    // Queues one example shaped like options.example_shape.
+    std::future<torch::Tensor> submit(torch::Tensor example);
+
+    // Blocking convenience wrapper around submit.
+    torch::Tensor infer(torch::Tensor example);
+
+    inference_stats stats();
+};
+
+#endif // INFERENCE_ENGINE_HPP
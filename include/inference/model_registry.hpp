@@ -0,0 +1,77 @@
+#ifndef MODEL_REGISTRY_HPP
+#define MODEL_REGISTRY_HPP
+
+#include <torch/script.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+struct model_registry_options {
+    // Convert conv weights to NHWC before freezing (see inference_engine_options)
+    bool channels_last;
+    // Read and write the pre-optimised artefact next to the source module
+    bool use_cache;
+
+    model_registry_options() : channels_last(false), use_cache(true) {}
+};
+
+// One loaded, frozen and optimised model version. Shared by every request that picked it
+// up; forward() is thread-safe, so callers use 'module' directly.
+struct served_model {
+    torch::jit::Module module;
+    std::string source_path;
+    std::string cache_path;
+    bool from_cache;
+    double load_ms;
+
+    served_model() : from_cache(false), load_ms(0) {}
+};
+
+// Named models, loaded on first use and replaced without blocking readers.
+//
+// Cold start: the first load of a module freezes and optimises it, then saves the result
+// beside the source as "<source>.<key>.opt.pt". The key hashes the libtorch version, the CPU
+// capability libtorch dispatches to, the MKLDNN version, the layout option and the source
+// file's size and mtime, so a cache built on another machine or for an older file is
+// never picked up. When the fully optimised graph cannot be serialised (MKLDNN-packed
+// constants), the frozen graph is cached instead and only the last pass re-runs at load.
+class model_registry
+{
+private:
+    struct entry {
+        std::mutex load_mutex; // serialises loads of this name; readers never take it
+        std::string path;
+        std::shared_ptr<served_model> current;
+    };
+
+    model_registry_options options;
+    std::mutex entries_mutex;
+    std::unordered_map<std::string, std::unique_ptr<entry>> entries;
+
+    entry &find(const std::string &name);
+
+public:
+    explicit model_registry(model_registry_options options = model_registry_options()) : options(options) {}
+
+    // Describes this process: libtorch version, CPU capability and MKLDNN version.
+    static std::string environment_key();
+
+    // Where the optimised artefact of 'model_path' lives for this environment and options.
+    static std::string cache_path(const std::string &model_path, const model_registry_options &options);
+
+    // Loads a TorchScript file, through the cache when enabled.
+    static std::shared_ptr<served_model> load_model(const std::string &path, const model_registry_options &options);
+
+    // Registers a name without loading anything.
+    void add(const std::string &name, const std::string &path);
+
+    // The current version of 'name', loaded on first use. Throws std::out_of_range for unknown names.
+    std::shared_ptr<served_model> get(const std::string &name);
+
+    // Loads 'path' fully, then atomically makes it the current version of 'name'.
+    // Requests in flight keep the version they started with.
+    void swap(const std::string &name, const std::string &path);
+};
+
+#endif // MODEL_REGISTRY_HPP
@@ -0,0 +1,20 @@
+#ifndef INTERNAL_CASS_HELPERS_HPP
+#define INTERNAL_CASS_HELPERS_HPP
+
+#include <cassandra.h>
+#include <string>
+
+// Driver helpers shared by the db translation units; not part of any module's interface.
+namespace internal
+{
+    // Error message of a failed driver future
+    inline std::string future_error(CassFuture *future)
+    {
+        const char *message;
+        size_t message_length;
+        cass_future_error_message(future, &message, &message_length);
+        return std::string(message, message_length);
+    }
+}
+
+#endif // INTERNAL_CASS_HELPERS_HPP
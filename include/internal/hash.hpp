@@ -0,0 +1,25 @@
+#ifndef INTERNAL_HASH_HPP
+#define INTERNAL_HASH_HPP
+
+#include <cstdint>
+
+// Hashing helpers shared by several translation units; not part of any module's interface.
+namespace internal
+{
+    // SplitMix64 finaliser: spreads neighbouring inputs over all 64 bits. Used to hash
+    // composite keys and to derive seeds.
+    inline uint64_t mix(uint64_t x)
+    {
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    // Full SplitMix64 step (golden-ratio increment, then the finaliser), so mix_step(0) != 0
+    inline uint64_t mix_step(uint64_t x)
+    {
+        return mix(x + 0x9E3779B97F4A7C15ULL);
+    }
+}
+
+#endif // INTERNAL_HASH_HPP
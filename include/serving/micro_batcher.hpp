@@ -0,0 +1,150 @@
+#ifndef MICRO_BATCHER_HPP
+#define MICRO_BATCHER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+// Counters of a micro-batching server.
+struct serving_stats {
+    int64_t requests;
+    int64_t batches;
+    double requests_per_second; // since construction or latency_recorder::restart
+    double mean_batch_size;
+    double mean_latency_us;
+    double p50_latency_us; // upper bound of the histogram bucket, within ~6%
+    double p99_latency_us;
+    double max_latency_us;
+
+    serving_stats()
+        : requests(0), batches(0), requests_per_second(0), mean_batch_size(0), mean_latency_us(0),
+          p50_latency_us(0), p99_latency_us(0), max_latency_us(0) {}
+};
+
+// Thread-safe request latencies of a micro-batching server, kept in a log-linear
+// histogram: 16 linear sub-buckets per power of two µs.
+class latency_recorder
+{
+private:
+    std::mutex lock;
+    int64_t requests, batches;
+    double latency_sum_us, latency_max_us;
+    std::vector<int64_t> histogram;
+    std::chrono::steady_clock::time_point started;
+
+    // Caller holds 'lock'
+    void add(double us);
+
+public:
+    latency_recorder();
+
+    // Restarts the throughput clock, e.g. once a warm-up is over.
+    void restart();
+
+    // Records a batch completed at 'done'; Request has a steady_clock 'submitted' member.
+    template <typename Request>
+    void record(const std::vector<Request> &batch, std::chrono::steady_clock::time_point done)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        requests += (int64_t)batch.size();
+        batches++;
+        for (const auto &r : batch)
+            add(std::chrono::duration<double, std::micro>(done - r.submitted).count());
+    }
+
+    serving_stats stats();
+};
+
+// Queue that hands concurrent requests out in micro-batches: the first request of a batch
+// waits up to 'window' for others to join it, and a batch is released as soon as it holds
+// max_batch requests. Any number of worker threads may call next(). Request is movable and
+// has a steady_clock 'submitted' member, stamped by push().
+// Throws std::invalid_argument unless max_batch >= 1 and window >= 0; a zero window hands
+// out whatever is queued without waiting.
+template <typename Request>
+class micro_batcher
+{
+private:
+    std::chrono::microseconds window;
+    size_t max_batch;
+
+    std::mutex lock;
+    std::condition_variable ready;
+    std::deque<Request> queue;
+    bool stopping;
+
+public:
+    micro_batcher(std::chrono::microseconds window, int64_t max_batch)
+        : window(window), max_batch((size_t)max_batch), stopping(false)
+    {
+        if (max_batch < 1)
+            throw std::invalid_argument("micro_batcher max_batch must be at least 1");
+        if (window.count() < 0)
+            throw std::invalid_argument("micro_batcher window must not be negative");
+    }
+
+    // Queues a request; false (and the request is dropped) once close() has been called.
+    bool push(Request r)
+    {
+        r.submitted = std::chrono::steady_clock::now();
+        size_t pending;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (stopping)
+                return false;
+            queue.push_back(std::move(r));
+            pending = queue.size();
+        }
+
+        // Wake a worker to open a batch window, or to close it early once full
+        if (pending == 1 || pending >= max_batch)
+            ready.notify_one();
+        return true;
+    }
+
+    // Moves the next batch into the empty 'batch'. Blocks until one is due; false once
+    // closed and drained.
+    bool next(std::vector<Request> &batch)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        while (true)
+        {
+            ready.wait(guard, [&] { return stopping || !queue.empty(); });
+            if (queue.empty())
+                return false; // stopping and fully drained
+
+            // Give concurrent callers until the window closes to join this batch
+            auto deadline = queue.front().submitted + window;
+            ready.wait_until(guard, deadline, [&] { return stopping || queue.size() >= max_batch; });
+            if (queue.empty())
+                continue; // another worker took the batch
+
+            while (!queue.empty() && batch.size() < max_batch)
+            {
+                batch.push_back(std::move(queue.front()));
+                queue.pop_front();
+            }
+
+            // Requests left over start the next window on an idle worker
+            if (!queue.empty())
+                ready.notify_one();
+            return true;
+        }
+    }
+
+    // Stops accepting requests; next() still hands out what is queued.
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        ready.notify_all();
+    }
+};
+
+#endif // MICRO_BATCHER_HPP
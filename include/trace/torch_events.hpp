@@ -0,0 +1,26 @@
+#ifndef TORCH_EVENTS_HPP
+#define TORCH_EVENTS_HPP
+
+#include <ATen/record_function.h>
+
+// Forwards torch's RecordFunction events (one per ATen operator, on every thread including
+// the intra-op pool) into the tracer, so operator spans nest under the pipeline's own spans
+// in the exported trace. Only spans recorded while the tracer runs are kept.
+//
+// RecordFunction callbacks are only installed while an instance is alive, since having
+// any installed makes every operator call pay for building its RecordFunction.
+class torch_events
+{
+private:
+    at::CallbackHandle handle;
+
+public:
+    torch_events();
+
+    ~torch_events();
+
+    torch_events(const torch_events &) = delete;
+    torch_events &operator=(const torch_events &) = delete;
+};
+
+#endif // TORCH_EVENTS_HPP
@@ -0,0 +1,90 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One completed span. 'name' and 'category' must point at storage that outlives the
+// tracer (string literals, or names owned by the torch dispatcher).
+struct trace_event {
+    const char *name;
+    const char *category;
+    int64_t start_ns;
+    int64_t duration_ns;
+    uint32_t tid;
+
+    trace_event() : name(nullptr), category(nullptr), start_ns(0), duration_ns(0), tid(0) {}
+};
+
+// Process-wide span recorder. Every thread writes its spans into its own fixed-size ring
+// buffer (no locks on the hot path; the oldest spans are overwritten when it fills up).
+// While stopped a span costs one relaxed atomic load.
+class tracer
+{
+private:
+    static std::atomic<bool> active;
+
+public:
+    // Begins a new session; spans from earlier sessions are discarded.
+    static void start(size_t events_per_thread = 1 << 18);
+
+    static void stop();
+
+    static bool enabled() { return active.load(std::memory_order_relaxed); }
+
+    // Monotonic clock in nanoseconds.
+    static int64_t now_ns();
+
+    static void record(const char *name, const char *category, int64_t start_ns, int64_t end_ns);
+
+    // All spans of the current session ordered by start time. Call after stop(), once the
+    // traced threads are done, to avoid reading slots that are being overwritten.
+    static std::vector<trace_event> collect();
+
+    // Spans lost to ring buffer wrap-around in the current session.
+    static uint64_t dropped();
+
+    // Chrome trace event format ("X" complete events); opens in chrome://tracing and Perfetto.
+    static void write_chrome_trace(const std::string &path);
+};
+
+// Records the enclosing scope as a span when the tracer is running.
+class trace_span
+{
+private:
+    const char *name;
+    const char *category;
+    int64_t start;
+
+public:
+    trace_span(const char *name, const char *category)
+        : name(name), category(category), start(tracer::enabled() ? tracer::now_ns() : -1) {}
+
+    ~trace_span()
+    {
+        if (start >= 0)
+            tracer::record(name, category, start, tracer::now_ns());
+    }
+
+    trace_span(const trace_span &) = delete;
+    trace_span &operator=(const trace_span &) = delete;
+};
+
+// Starts the tracer when 'path' is not empty and writes the trace there on destruction.
+class trace_session
+{
+private:
+    std::string path;
+
+public:
+    explicit trace_session(const std::string &path, size_t events_per_thread = 1 << 18);
+
+    ~trace_session();
+
+    // The TRACE_OUT environment variable, or an empty string.
+    static std::string path_from_env();
+};
+
+#endif // TRACE_HPP
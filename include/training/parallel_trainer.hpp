@@ -0,0 +1,89 @@
+#ifndef PARALLEL_TRAINER_HPP
+#define PARALLEL_TRAINER_HPP
+
+#include <torch/torch.h>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Forward + loss for one shard on one replica. The loss must be a mean over the shard's
+// rows, so shard gradients can be combined by row-weighted averaging.
+using trainer_loss_fn =
+    std::function<torch::Tensor(torch::nn::Module &replica, const torch::Tensor &input, const torch::Tensor &target)>;
+
+// Synchronous data-parallel training on CPU threads.
+//
+// The model is cloned once per worker (it must be Cloneable, as nn::Linear, nn::Sequential
+// and modules deriving from nn::Cloneable are); worker 0 trains the caller's model itself.
+// step() splits a batch along dim 0, runs forward/backward on every replica concurrently,
+// then all-reduces: worker w owns the w-th contiguous slice of every gradient and sums that
+// slice over all replicas into the caller's model, so the reduction needs no locks and
+// runs on all workers at once. The caller then steps its usual optimizer on model->parameters();
+// replicas pick up the new weights at the start of the next step.
+//
+// Buffers (e.g. BatchNorm running stats) are copied from the model to the replicas every
+// step and only the model's own shard updates them.
+class parallel_trainer
+{
+private:
+    // Reusable barrier for a fixed number of threads
+    struct barrier {
+        std::mutex mutex;
+        std::condition_variable cv;
+        int count, waiting;
+        uint64_t generation;
+
+        explicit barrier(int count) : count(count), waiting(0), generation(0) {}
+
+        void arrive_and_wait();
+    };
+
+    std::shared_ptr<torch::nn::Module> model;
+    std::vector<std::shared_ptr<torch::nn::Module>> replicas; // replicas[0] is 'model'
+    std::vector<std::vector<torch::Tensor>> parameters;      // per replica, same order
+    std::vector<std::vector<torch::Tensor>> buffers;
+    trainer_loss_fn loss_fn;
+    int n_workers;
+
+    // Current step, written by step() before the workers are released
+    torch::Tensor input, target;
+    std::vector<int64_t> shard_begin, shard_end;
+    std::vector<double> shard_loss;
+    std::vector<std::exception_ptr> errors;
+
+    std::mutex step_mutex;
+    std::condition_variable step_cv, done_cv;
+    uint64_t generation;
+    int finished;
+    bool stopping;
+    barrier sync;
+    std::vector<std::thread> workers;
+
+    void worker_loop(int w);
+
+    void forward_backward(int w);
+
+    void all_reduce(int w);
+
+public:
+    // n_workers = 0 uses one worker per hardware thread.
+    parallel_trainer(std::shared_ptr<torch::nn::Module> model, trainer_loss_fn loss_fn, int n_workers = 0);
+
+    ~parallel_trainer();
+
+    parallel_trainer(const parallel_trainer &) = delete;
+    parallel_trainer &operator=(const parallel_trainer &) = delete;
+
+    // One data-parallel forward/backward over [N, ...] input and target (N >= workers).
+    // Leaves the row-weighted average gradient in model's parameters and returns the mean loss.
+    double step(const torch::Tensor &input, const torch::Tensor &target);
+
+    int worker_count() const { return n_workers; }
+};
+
+#endif // PARALLEL_TRAINER_HPP
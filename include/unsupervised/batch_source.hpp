@@ -0,0 +1,75 @@
+#ifndef BATCH_SOURCE_HPP
+#define BATCH_SOURCE_HPP
+
+#include <torch/torch.h>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Produces a dataset as a sequence of [rows, features] float batches.
+// next() returns an undefined tensor once the source is exhausted.
+class batch_source
+{
+public:
+    virtual ~batch_source() = default;
+
+    virtual torch::Tensor next() = 0;
+
+    // Rewinds to the first batch, for sources that can be replayed.
+    virtual void reset() {}
+};
+
+// Walks an in-memory tensor in row slices (views, no copies).
+class tensor_batch_source : public batch_source
+{
+private:
+    torch::Tensor data;
+    int64_t batch_size;
+    int64_t offset;
+
+public:
+    tensor_batch_source(torch::Tensor data, int64_t batch_size) : data(data), batch_size(batch_size), offset(0) {}
+
+    torch::Tensor next() override;
+
+    void reset() override;
+};
+
+// Reads numeric columns from a CSV file 'batch_size' lines at a time into one reused buffer,
+// so memory is bounded by a single batch whatever the file size.
+// The returned tensor aliases that buffer and is only valid until the next call.
+class csv_batch_source : public batch_source
+{
+private:
+    std::string path;
+    std::vector<int> column_indices;
+    int64_t batch_size;
+    std::ifstream file;
+    torch::Tensor buffer;
+    int64_t skipped;
+
+public:
+    csv_batch_source(const std::string &path, std::vector<int> column_indices, int64_t batch_size);
+
+    torch::Tensor next() override;
+
+    void reset() override;
+
+    // Lines that could not be parsed so far.
+    int64_t skipped_lines() const { return skipped; }
+};
+
+// Adapts any producer (e.g. a paged Cassandra query) to the batch_source interface.
+class function_batch_source : public batch_source
+{
+private:
+    std::function<torch::Tensor()> producer;
+
+public:
+    function_batch_source(std::function<torch::Tensor()> producer) : producer(std::move(producer)) {}
+
+    torch::Tensor next() override { return producer(); }
+};
+
+#endif // BATCH_SOURCE_HPP
@@ -0,0 +1,35 @@
+#ifndef BOUNDED_KMEANS_HPP
+#define BOUNDED_KMEANS_HPP
+
+#include <torch/torch.h>
+#include <cstdint>
+
+// Work done by a triangle-inequality accelerated k-means run.
+// Lloyd's algorithm would evaluate n·K distances per iteration; 'distances_skipped'
+// is how many of those the bounds proved unnecessary.
+struct kmeans_stats {
+    int iterations;
+    int64_t distances_computed;
+    int64_t distances_skipped;
+
+    kmeans_stats() : iterations(0), distances_computed(0), distances_skipped(0) {}
+};
+
+// Both variants start from 'init_centroids' [K, D] when defined, otherwise from K random
+// rows drawn with a generator seeded by 'seed', so a run is reproducible for a given seed.
+// Given the same start they assign every point as Lloyd's k-means does.
+
+// Hamerly's k-means: one upper bound to the assigned centroid and one lower bound to
+// the second closest centroid per point. O(n) extra memory, best for small K.
+// Runs on CPU, parallel over points on the ATen intra-op thread pool.
+torch::Tensor kmeans_hamerly(torch::Tensor projected, int K, int max_iters = 100, float tol = 1e-4,
+                             kmeans_stats *stats = nullptr, bool verbose = true, uint64_t seed = 0,
+                             const torch::Tensor &init_centroids = torch::Tensor());
+
+// Elkan's k-means: one upper bound and K lower bounds per point plus the K×K
+// centroid distances. O(n·K) extra memory, skips more work than Hamerly for large K.
+torch::Tensor kmeans_elkan(torch::Tensor projected, int K, int max_iters = 100, float tol = 1e-4,
+                           kmeans_stats *stats = nullptr, bool verbose = true, uint64_t seed = 0,
+                           const torch::Tensor &init_centroids = torch::Tensor());
+
+#endif // BOUNDED_KMEANS_HPP
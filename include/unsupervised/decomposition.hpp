@@ -0,0 +1,64 @@
+#ifndef DECOMPOSITION_HPP
+#define DECOMPOSITION_HPP
+
+#include <torch/torch.h>
+#include "unsupervised/workspace.hpp"
+
+// Fitted PCA: the training mean [1, F] and the kept components [F, C].
+struct pca_model {
+    torch::Tensor mean;
+    torch::Tensor components;
+
+    // Projects new rows [N, F] into the reduced space [N, C]. Sparse rows are centred
+    // after the product, so they never densify to [N, F].
+    torch::Tensor project(const torch::Tensor &data) const
+    {
+        if (data.is_sparse() || data.layout() == torch::kSparseCsr)
+            return torch::mm(data.to(mean.device()), components) - torch::mm(mean, components);
+        return torch::matmul(data.to(mean.device()) - mean, components);
+    }
+};
+
+// Fits PCA and keeps the components that explain ~92% of the variance.
+// The covariance is accumulated from centred row chunks and eigendecomposed, so besides
+// 'data' only one chunk (from 'ws' when given) and the [F, F] covariance are held; the
+// centred matrix is never materialised. When 'projected' is given it receives the
+// projection of 'data' on the compute device, written in place when it already has the
+// right shape and type.
+pca_model pca_fit(torch::Tensor data, torch::Tensor *projected = nullptr, workspace *ws = nullptr);
+
+// Same as pca_fit but only returns the projection.
+torch::Tensor pca(torch::Tensor data);
+
+struct truncated_svd_options {
+    int64_t oversample;   // extra random directions beyond the requested rank
+    int power_iters;      // subspace iterations; more sharpen a slowly decaying spectrum
+    bool center;          // factor (data - column mean) without ever forming it
+    uint64_t seed;
+
+    truncated_svd_options() : oversample(10), power_iters(4), center(true), seed(0) {}
+};
+
+// Rank-k factorisation data ≈ U diag(S) Vᵀ (of the centred data when options.center).
+struct truncated_svd_result {
+    torch::Tensor U;    // [N, k]
+    torch::Tensor S;    // [k], descending
+    torch::Tensor V;    // [F, k]
+    torch::Tensor mean; // [1, F], zeros when not centring
+
+    // Squared Frobenius norm of the (centred) input, i.e. the total variance × (N - 1)
+    double total_ss;
+};
+
+// Randomised truncated SVD (Halko, Martinsson & Tropp) that touches 'data' only through
+// products with tall-skinny dense blocks, so a sparse COO/CSR matrix stays sparse.
+// Centring is applied implicitly: (A - 1μᵀ)X = AX - 1(μᵀX).
+truncated_svd_result truncated_svd(const torch::Tensor &data, int64_t k,
+                                   const truncated_svd_options &options = truncated_svd_options());
+
+// PCA for sparse fingerprints: runs truncated_svd with up to 'max_components' and keeps the
+// leading components that explain ~92% of the total variance.
+pca_model sparse_pca_fit(const torch::Tensor &data, int64_t max_components, torch::Tensor *projected = nullptr,
+                         const truncated_svd_options &options = truncated_svd_options());
+
+#endif // DECOMPOSITION_HPP
@@ -0,0 +1,49 @@
+#ifndef IVF_INDEX_HPP
+#define IVF_INDEX_HPP
+
+#include <torch/torch.h>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Inverted-file (IVF-Flat) approximate nearest-neighbour index for fingerprint vectors.
+// k-means centroids act as the coarse quantiser: every stored vector lives in the list of
+// its nearest centroid, and a query only scans the n_probe lists closest to it.
+// Vectors are stored contiguously in list order, so scanning a list is a linear pass.
+class ivf_index
+{
+private:
+    int n_lists;
+    int64_t dims;
+    torch::Tensor centroids_;     // [L, D]
+    torch::Tensor centroid_sq;    // ‖c‖² [L]
+    torch::Tensor vectors;        // [N, D] grouped by list
+    torch::Tensor ids;            // [N] original row of every stored vector
+    std::vector<int64_t> offsets; // list l holds vectors[offsets[l], offsets[l + 1])
+
+public:
+    explicit ivf_index(int n_lists) : n_lists(n_lists), dims(0) {}
+
+    // Trains the coarse quantiser with kmeans_fit (restarts run on worker threads), then indexes 'data'.
+    // Both builds throw std::invalid_argument unless n_lists >= 1.
+    void build(const torch::Tensor &data, uint64_t seed = 0, int n_init = 1);
+
+    // Indexes 'data' under existing centroids, e.g. the zones from kmeans_fit.
+    void build(const torch::Tensor &data, const torch::Tensor &centroids);
+
+    // Batch k-NN. Returns squared distances [Q, k] (ascending) and row ids [Q, k];
+    // slots with no candidate hold +inf and -1. Queries run in parallel. Throws
+    // std::invalid_argument unless k >= 1, n_probe >= 1 (n_probe is capped at n_lists) and
+    // the queries are [Q, D] with the indexed D.
+    std::pair<torch::Tensor, torch::Tensor> search(const torch::Tensor &queries, int k, int n_probe) const;
+
+    int64_t size() const { return ids.defined() ? ids.size(0) : 0; }
+
+    const torch::Tensor &centroids() const { return centroids_; }
+};
+
+// Exact k-NN by brute force, for recall measurements. Same return convention as
+// ivf_index::search: always [Q, k], padded with +inf and -1 when k exceeds the data rows.
+std::pair<torch::Tensor, torch::Tensor> exact_knn(const torch::Tensor &data, const torch::Tensor &queries, int k);
+
+#endif // IVF_INDEX_HPP
@@ -0,0 +1,66 @@
+#ifndef K_SELECTION_HPP
+#define K_SELECTION_HPP
+
+#include <torch/torch.h>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+struct k_selection_options {
+    int k_min, k_max, k_step;
+
+    // Lloyd settings for every K. Warm starts converge quickly, so few iterations are needed.
+    int max_iters;
+    float tol;
+
+    // Rows used to fit each K (0 = all rows).
+    int64_t fit_sample;
+    // Rows used for the sampled silhouette; its cost is O(silhouette_sample²).
+    int64_t silhouette_sample;
+
+    // The sweep stops starting new K values once this much time has passed.
+    std::chrono::milliseconds time_budget;
+
+    uint64_t seed;
+    bool verbose;
+
+    k_selection_options()
+        : k_min(2), k_max(16), k_step(1), max_iters(50), tol(1e-4), fit_sample(200000), silhouette_sample(4000),
+          time_budget(60000), seed(0), verbose(false) {}
+};
+
+struct k_score {
+    int K;
+    // Mean squared distance to the assigned centroid over the fit sample.
+    double inertia;
+    // Mean silhouette over the silhouette sample, in [-1, 1].
+    double silhouette;
+    int iterations;
+
+    k_score() : K(0), inertia(0), silhouette(0), iterations(0) {}
+};
+
+struct k_selection_result {
+    std::vector<k_score> scores;
+    int best_silhouette_k;
+    // K at the knee of the inertia curve (largest distance below the first-to-last chord).
+    int elbow_k;
+    // Highest silhouette; falls back to the elbow when the silhouette is not informative.
+    int recommended_k;
+    // True when the time budget cut the sweep short.
+    bool budget_exhausted;
+
+    k_selection_result() : best_silhouette_k(0), elbow_k(0), recommended_k(0), budget_exhausted(false) {}
+};
+
+// Silhouette score estimated on 'sample_size' random rows: exact a(i)/b(i) against the
+// sample instead of all points, which keeps the cost at O(sample_size²).
+double sampled_silhouette(const torch::Tensor &points, const torch::Tensor &labels, int K, int64_t sample_size,
+                          uint64_t seed);
+
+// Sweeps K over [k_min, k_max]. Each K is warm-started from the previous centroids plus
+// new seeds drawn k-means++ style, and its silhouette is computed on a background
+// thread while the next K is being fitted.
+k_selection_result select_k(const torch::Tensor &projected, const k_selection_options &options);
+
+#endif // K_SELECTION_HPP
@@ -0,0 +1,70 @@
+#ifndef KMEANS_HPP
+#define KMEANS_HPP
+
+#include <torch/torch.h>
+#include <cstdint>
+#include "unsupervised/workspace.hpp"
+
+struct kmeans_options {
+    int K;
+    int max_iters;
+    float tol;
+
+    // Independent restarts; the one with the lowest inertia wins.
+    int n_init;
+    // Restart r is seeded with seed + r, so results are reproducible for a given seed.
+    uint64_t seed;
+    // Restarts run concurrently on this many threads, at most at::get_num_threads().
+    // 0 = all of them when n_init fills that budget, otherwise one restart at a time.
+    int n_threads;
+
+    bool verbose;
+
+    // Optional warm start [K, D]. When defined a single run starts from it and n_init is ignored.
+    torch::Tensor init_centroids;
+
+    kmeans_options(int K) : K(K), max_iters(100), tol(1e-4), n_init(1), seed(0), n_threads(0), verbose(false) {}
+};
+
+struct kmeans_result {
+    torch::Tensor labels;
+    torch::Tensor centroids;
+    // Sum of squared distances of every point to its centroid.
+    double inertia;
+    int iterations;
+    int best_run;
+
+    kmeans_result() : inertia(0), iterations(0), best_run(0) {}
+};
+
+// Assignment step. Writes the nearest centroid of every row of 'points' into 'labels'
+// and the squared distance to it into 'min_dists'.
+// Distances use the GEMM form ‖x‖² − 2xcᵀ + ‖c‖²: 'x_sq' holds the precomputed ‖x‖²
+// [N] and 'dists' [N, K] is a caller-owned workspace that is overwritten. With 'c_sq'
+// (a [K] workspace for ‖c‖²) the step allocates nothing.
+void kmeans_assign(const torch::Tensor &points, const torch::Tensor &x_sq, const torch::Tensor &centroids,
+                   torch::Tensor &dists, torch::Tensor &min_dists, torch::Tensor &labels,
+                   torch::Tensor *c_sq = nullptr);
+
+// Update step. Computes the mean of every cluster into 'new_centroids' with a single
+// index_add_ for the sums and one for the counts; empty clusters keep their old centroid.
+// 'ones' [N], 'sums' [K, D] and 'counts' [K] are caller-owned workspaces; 'counts' is left
+// clamped to at least 1. With 'non_empty' (a [K] bool workspace) the step allocates nothing.
+void kmeans_update(const torch::Tensor &points, const torch::Tensor &labels, const torch::Tensor &centroids,
+                   const torch::Tensor &ones, torch::Tensor &sums, torch::Tensor &counts,
+                   torch::Tensor &new_centroids, torch::Tensor *non_empty = nullptr);
+
+// Lloyd's k-means. Returns the cluster label of every row of 'projected'.
+// Passing a workspace reuses its buffers across calls; the returned labels are then a copy.
+torch::Tensor kmeans(torch::Tensor projected, int n_samples, int K, int max_iters = 100, float tol = 1e-4,
+                     bool verbose = true, workspace *ws = nullptr);
+
+// Lloyd's k-means with options.n_init seeded restarts run in parallel.
+// Returns the labels and centroids of the restart with the lowest inertia.
+// The caller's at::get_num_threads() is the thread budget and is left unchanged. With one
+// thread the restarts run in turn with full intra-op parallelism; otherwise each runs
+// single-threaded on a thread of the intra-op pool, which keeps one workspace for all the
+// restarts it runs. Throws std::invalid_argument unless 1 <= K <= n.
+kmeans_result kmeans_fit(const torch::Tensor &projected, const kmeans_options &options);
+
+#endif // KMEANS_HPP
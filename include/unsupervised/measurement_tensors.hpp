@@ -0,0 +1,33 @@
+#ifndef MEASUREMENT_TENSORS_HPP
+#define MEASUREMENT_TENSORS_HPP
+
+#include <torch/torch.h>
+#include <vector>
+#include <db/access/measurement_batch.hpp>
+
+// Zero-copy [N] tensor over a numeric column of a measurement_batch. The tensor aliases the
+// column's memory: it must not outlive the batch, and appending to the column (which may
+// reallocate) invalidates it. Writes through the tensor change the batch.
+template <typename T>
+torch::Tensor column_tensor(const std::vector<T> &values)
+{
+    return torch::from_blob(const_cast<T *>(values.data()), {(int64_t)values.size()},
+                            torch::TensorOptions().dtype(c10::CppTypeToScalarType<T>::value));
+}
+
+template <typename T>
+torch::Tensor column_tensor(const column<T> &c)
+{
+    return column_tensor(c.values);
+}
+
+// Unpacked validity bits as a bool [N] tensor (a copy: 1 byte per row instead of 1 bit).
+torch::Tensor validity_mask(const validity_bitmap &validity);
+
+template <typename T>
+torch::Tensor validity_mask(const column<T> &c)
+{
+    return validity_mask(c.validity);
+}
+
+#endif // MEASUREMENT_TENSORS_HPP
@@ -0,0 +1,47 @@
+#ifndef MINIBATCH_KMEANS_HPP
+#define MINIBATCH_KMEANS_HPP
+
+#include <torch/torch.h>
+#include "unsupervised/batch_source.hpp"
+
+// Mini-batch k-means (Sculley, 2010). Each centroid keeps the number of points it has
+// absorbed and moves towards the mean of its batch members with learning rate
+// n_batch / n_total, so only one batch is ever resident.
+class minibatch_kmeans
+{
+private:
+    int K;
+    torch::Tensor centroids_;
+    torch::Tensor counts_;
+    double last_inertia;
+
+    // Batch-sized workspaces, reused while the batch size does not change
+    torch::Tensor x_sq, dists, min_dists, labels, ones, sums, batch_counts;
+
+    void init_centroids(const torch::Tensor &batch);
+
+public:
+    minibatch_kmeans(int K) : K(K), last_inertia(0) {}
+
+    // Updates the model with one batch [rows, features]. The first call seeds the
+    // centroids from K random rows, so it needs at least K rows.
+    void partial_fit(const torch::Tensor &batch);
+
+    // Streams 'source' for the given number of passes, calling partial_fit on every batch.
+    void fit(batch_source &source, int epochs = 1);
+
+    // Nearest centroid of every row of 'points'.
+    torch::Tensor predict(const torch::Tensor &points) const;
+
+    bool initialized() const { return centroids_.defined(); }
+
+    const torch::Tensor &centroids() const { return centroids_; }
+
+    // Points absorbed by every centroid so far.
+    const torch::Tensor &counts() const { return counts_; }
+
+    // Sum of squared distances of the last batch to its centroids (before the update).
+    double last_batch_inertia() const { return last_inertia; }
+};
+
+#endif // MINIBATCH_KMEANS_HPP
@@ -0,0 +1,34 @@
+#ifndef OCID_DATASET_HPP
+#define OCID_DATASET_HPP
+
+#include <torch/torch.h>
+#include <string>
+#include <vector>
+
+// OCID feature rows as a batch-level torch dataset.
+//
+// torch::data::datasets::Dataset builds one Example per index and Stack<> concatenates
+// them, i.e. one small tensor and one copy per row. Here the sampler's index list is
+// turned into a single index_select per tensor, so a batch costs one gather whatever its
+// size. get_batch only reads shared tensors and is safe to call from loader workers.
+class ocid_dataset : public torch::data::datasets::BatchDataset<ocid_dataset, torch::data::Example<>, std::vector<size_t>>
+{
+private:
+    torch::Tensor features; // [N, F], contiguous
+    torch::Tensor targets;  // [N] or [N, T]; undefined when unlabeled
+
+public:
+    // 'targets' may be undefined, in which case batches carry an undefined target.
+    explicit ocid_dataset(torch::Tensor features, torch::Tensor targets = torch::Tensor());
+
+    // Dataset over a fingerprint snapshot, memory-mapped by default instead of read.
+    static ocid_dataset from_snapshot(const std::string &path, bool mmap = true);
+
+    torch::data::Example<> get_batch(std::vector<size_t> indices) override;
+
+    torch::optional<size_t> size() const override;
+
+    int64_t feature_count() const { return features.size(1); }
+};
+
+#endif // OCID_DATASET_HPP
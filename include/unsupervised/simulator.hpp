@@ -0,0 +1,42 @@
+#ifndef SIMULATOR_HPP
+#define SIMULATOR_HPP
+
+#include <torch/torch.h>
+#include <cstdint>
+#include <string>
+
+// RSSI from 8 sectors × 3 bands followed by TA from 8 cells.
+constexpr int64_t simulator_features = 32;
+
+struct simulator_options {
+    // Rows per chunk. Chunk c covers rows [c * chunk_rows, (c + 1) * chunk_rows).
+    int64_t chunk_rows;
+    // Every chunk draws from its own generator seeded from (seed, chunk index),
+    // so the dataset is identical whatever the thread count and any chunk can be regenerated alone.
+    uint64_t seed;
+
+    simulator_options() : chunk_rows(65536), seed(0) {}
+};
+
+// Fills 'out' [rows, simulator_features] with chunk 'chunk_index' of the dataset.
+void simulate_chunk(torch::Tensor out, int64_t chunk_index, uint64_t seed);
+
+// The generators below throw std::invalid_argument when n_samples < 0 or chunk_rows < 1.
+
+// Generates n_samples rows into one preallocated tensor, chunks in parallel.
+torch::Tensor simulate_fingerprints(int64_t n_samples, const simulator_options &options = simulator_options());
+
+// Streams n_samples rows to a binary snapshot (see snapshot.hpp). Memory stays at one
+// chunk per worker thread, so the dataset can be larger than RAM.
+void simulate_to_snapshot(const std::string &path, int64_t n_samples,
+                          const simulator_options &options = simulator_options());
+
+// Generates in memory and writes a torch::save tensor file.
+void simulate_to_tensor_file(const std::string &path, int64_t n_samples,
+                             const simulator_options &options = simulator_options());
+
+// Simulates a realistic RF fingerprint matrix [n_samples × simulator_features], seeded from
+// the global torch RNG. 'n_features' is kept for compatibility; the layout is fixed.
+torch::Tensor sampleSimulator(int n_samples, int n_features);
+
+#endif // SIMULATOR_HPP
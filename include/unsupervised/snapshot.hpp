@@ -0,0 +1,50 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <torch/torch.h>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+// Binary snapshot of a float32 feature matrix: a fixed header followed by the
+// row-major data, so it can be appended chunk by chunk and read back (or mapped) in place.
+struct snapshot_header {
+    char magic[8];
+    int64_t rows;
+    int64_t cols;
+    uint64_t seed; // generator seed, 0 when not synthetic
+
+    snapshot_header() : magic{'F', 'P', 'S', 'N', 'A', 'P', '0', '1'}, rows(0), cols(0), seed(0) {}
+
+    bool valid() const;
+};
+
+// Appends row chunks to a snapshot file; the header is written up front with the final row count.
+class snapshot_writer
+{
+private:
+    std::ofstream file;
+    snapshot_header header;
+    int64_t written;
+
+public:
+    snapshot_writer(const std::string &path, int64_t rows, int64_t cols, uint64_t seed = 0);
+
+    // Appends a [r, cols] chunk; converted to contiguous float32 if needed.
+    void append(const torch::Tensor &chunk);
+
+    // Checks that exactly 'rows' rows were written and flushes the file.
+    void close();
+};
+
+snapshot_header read_snapshot_header(const std::string &path);
+
+// Reads a whole snapshot into memory.
+torch::Tensor load_snapshot(const std::string &path);
+
+// Maps a snapshot read-only and wraps the data in place; pages are loaded on first touch
+// and the mapping is released with the last tensor that shares its storage.
+// The tensor must not be written to.
+torch::Tensor map_snapshot(const std::string &path);
+
+#endif // SNAPSHOT_HPP
@@ -0,0 +1,111 @@
+#ifndef SPARSE_FINGERPRINTS_HPP
+#define SPARSE_FINGERPRINTS_HPP
+
+#include <torch/torch.h>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <db/access/measurement.hpp>
+#include <db/access/measurement_batch.hpp>
+
+// Sparse location × cell fingerprints. Row r is a location bucket, column c a cell;
+// values are the mean of every measurement of that cell seen from that bucket.
+struct sparse_fingerprints {
+    torch::Tensor signal;  // [rows, cols] mean signal, sparse CSR or COO
+    torch::Tensor ta;      // [rows, cols] mean timing advance, same layout
+    torch::Tensor samples; // [rows, cols] measurement count per pair
+
+    // All three share one sparsity pattern; a pair that was seen but never reported
+    // a signal (or TA) stores 0, the access layer's "absent" value.
+
+    // Row dictionary: south-west corner of every location bucket
+    std::vector<core> row_locations;
+    // Column dictionary: cell identity (measured_at is 0)
+    std::vector<keys> col_cells;
+};
+
+struct sparse_fingerprint_options {
+    // Side of a square location bucket in degrees (0.001° ≈ 110 m)
+    double bucket_degrees;
+    // Aggregation maps are split into this many independently locked shards
+    int n_shards;
+    // Threads used by add(batch); 0 = one per hardware thread
+    unsigned n_threads;
+
+    sparse_fingerprint_options() : bucket_degrees(0.001), n_shards(64), n_threads(0) {}
+};
+
+// Streams measurement records into per-(bucket, cell) aggregates and emits sparse tensors.
+// Only the observed pairs are ever stored. Signal, TA and location follow the access
+// layer's "0 means absent" convention: absent values are not averaged in, and rows
+// without a location are dropped.
+class sparse_fingerprint_builder
+{
+private:
+    struct pair_key {
+        int64_t lat_row, lon_col;
+        int32_t mcc, mnc, lac;
+        int64_t cellid;
+
+        bool operator==(const pair_key &o) const
+        {
+            return lat_row == o.lat_row && lon_col == o.lon_col && cellid == o.cellid && lac == o.lac &&
+                   mnc == o.mnc && mcc == o.mcc;
+        }
+    };
+
+    struct pair_hash {
+        size_t operator()(const pair_key &k) const;
+    };
+
+    struct aggregate {
+        double signal_sum, ta_sum;
+        int64_t signal_count, ta_count, samples;
+
+        aggregate() : signal_sum(0), ta_sum(0), signal_count(0), ta_count(0), samples(0) {}
+
+        void merge(const aggregate &o);
+    };
+
+    using pair_map = std::unordered_map<pair_key, aggregate, pair_hash>;
+
+    struct shard {
+        mutable std::mutex lock;
+        pair_map pairs;
+    };
+
+    sparse_fingerprint_options options;
+    std::vector<shard> shards;
+
+    // The fields one record contributes, from either row or column storage
+    struct record;
+
+    bool key_of(const record &r, pair_key &key) const;
+
+    size_t shard_of(const pair_key &key) const;
+
+    template <typename Records>
+    void add_parallel(const Records &records, size_t n);
+
+public:
+    explicit sparse_fingerprint_builder(sparse_fingerprint_options options = sparse_fingerprint_options());
+
+    // Thread-safe single record insert.
+    void add(const measurement &m);
+
+    // Aggregates a batch on worker threads into thread-local maps, then merges them shard by shard.
+    void add(const std::vector<measurement> &batch);
+
+    // Same, reading the columns directly; null signal, TA or location are skipped the same
+    // way zeros are for measurement rows.
+    void add(const measurement_batch &batch);
+
+    // Number of distinct (bucket, cell) pairs seen so far.
+    size_t pairs() const;
+
+    // Emits the fingerprints with rows and columns sorted by bucket and cell.
+    sparse_fingerprints build(bool csr = true) const;
+};
+
+#endif // SPARSE_FINGERPRINTS_HPP
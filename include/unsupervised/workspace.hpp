@@ -0,0 +1,71 @@
+#ifndef WORKSPACE_HPP
+#define WORKSPACE_HPP
+
+#include <torch/torch.h>
+#include <c10/util/ThreadLocalDebugInfo.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Scratch buffers reused across iterations and calls. Each numbered slot owns one byte
+// buffer that only grows; get() returns a typed view over it, so a call whose shapes fit
+// in what earlier calls allocated touches the allocator not at all.
+//
+// Slot contents do not survive between calls of the algorithms that use them, and
+// results are never returned as views of a slot, so one workspace can be shared by
+// pca_fit(), kmeans() and kmeans_fit() runs on the same thread.
+class workspace
+{
+private:
+    std::vector<torch::Tensor> slots; // kByte buffers
+    int64_t grown;
+
+public:
+    workspace() : grown(0) {}
+
+    // A contiguous [sizes] tensor of options' dtype and device backed by 'slot'.
+    torch::Tensor get(size_t slot, torch::IntArrayRef sizes, const torch::TensorOptions &options);
+
+    // Bytes currently held across all slots.
+    int64_t bytes() const;
+
+    // How many times a slot had to be (re)allocated.
+    int64_t reallocations() const { return grown; }
+
+    void release();
+};
+
+struct allocation_stats {
+    int64_t allocations;
+    int64_t frees;
+    int64_t bytes_allocated;
+    // Highest net bytes (allocated − freed) since construction or reset()
+    int64_t peak_bytes;
+
+    allocation_stats() : allocations(0), frees(0), bytes_allocated(0), peak_bytes(0) {}
+};
+
+// Counts CPU tensor storage allocations made on this thread while it is alive, through
+// the allocator's profiler memory hook. Scratch inside third-party kernels (MKL, oneDNN) and
+// allocations on intra-op worker threads are not seen; frees of blocks allocated before
+// the counter existed are not counted. Replaces the autograd profiler's memory reporting
+// while active.
+class allocation_counter
+{
+private:
+    struct reporter;
+    std::shared_ptr<reporter> state;
+    std::unique_ptr<c10::DebugInfoGuard> guard;
+
+public:
+    allocation_counter();
+
+    ~allocation_counter();
+
+    allocation_stats stats() const;
+
+    // Zeroes the counters; net and peak bytes are measured from here on.
+    void reset();
+};
+
+#endif // WORKSPACE_HPP
@@ -0,0 +1,83 @@
+#ifndef ZONE_ASSIGNER_HPP
+#define ZONE_ASSIGNER_HPP
+
+#include <torch/torch.h>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "serving/micro_batcher.hpp"
+#include "unsupervised/decomposition.hpp"
+
+// Writes the PCA mean, components and k-means centroids to one file for zone_assigner::load.
+void save_zone_model(const std::string &path, const pca_model &model, const torch::Tensor &centroids);
+
+struct zone_assigner_options {
+    // How long the first request of a batch waits for others to join it (>= 0).
+    std::chrono::microseconds window;
+    // A batch is dispatched as soon as it reaches this many requests (>= 1).
+    int64_t max_batch;
+
+    zone_assigner_options() : window(200), max_batch(256) {}
+};
+
+using zone_assigner_stats = serving_stats;
+
+// In-process zone assignment. Concurrent callers are collected into micro-batches by a
+// dispatcher thread; each batch runs one fused project-and-argmin GEMM:
+//   argmin_k ‖(x − μ)W − c_k‖² = argmin_k (‖c_k‖² + 2μWc_kᵀ) − 2x(Wcᵀ)
+// so the PCA projection never has to be materialised.
+class zone_assigner
+{
+private:
+    struct request {
+        std::vector<float> fingerprint;
+        std::promise<int64_t> zone;
+        std::chrono::steady_clock::time_point submitted;
+    };
+
+    zone_assigner_options options;
+    int64_t n_features;
+    torch::Tensor weights; // W·cᵀ [F, K]
+    torch::Tensor bias;    // ‖c‖² + 2μWcᵀ [1, K]
+    torch::Tensor input;   // [max_batch, F] batch staging buffer
+    torch::Tensor scores;  // [max_batch, K]
+
+    micro_batcher<request> queue;
+    latency_recorder latencies;
+
+    std::thread dispatcher;
+
+    void dispatch_loop();
+
+    void run_batch(std::vector<request> &batch);
+
+public:
+    zone_assigner(const pca_model &model, const torch::Tensor &centroids,
+                  zone_assigner_options options = zone_assigner_options());
+
+    // Loads a file written by save_zone_model.
+    static std::unique_ptr<zone_assigner> load(const std::string &path,
+                                               zone_assigner_options options = zone_assigner_options());
+
+    // Drains the pending requests, then stops the dispatcher.
+    ~zone_assigner();
+
+    zone_assigner(const zone_assigner &) = delete;
+    zone_assigner &operator=(const zone_assigner &) = delete;
+
+    // Queues one raw fingerprint [F]; the future yields its zone.
+    std::future<int64_t> submit(std::vector<float> fingerprint);
+
+    // Blocking convenience wrapper around submit.
+    int64_t assign(std::vector<float> fingerprint);
+
+    int64_t features() const { return n_features; }
+
+    zone_assigner_stats stats();
+};
+
+#endif // ZONE_ASSIGNER_HPP
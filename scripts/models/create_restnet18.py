@@ -1,8 +1,10 @@
+import argparse
+
 import torch
 import torchvision
 
 
-def main():
+def export_fp32(example):
     # Source: https://github.com/yunjey/pytorch-tutorial/blob/master/tutorials/01-basics/pytorch_basics/main.py
     # Download and load the pretrained ResNet-18.
     model = torchvision.models.resnet18(pretrained=True)
@@ -15,9 +17,6 @@ def main():
     model.fc = torch.nn.Linear(model.fc.in_features, 100)
 
     # Source: https://pytorch.org/tutorials/advanced/cpp_export.html#converting-to-torch-script-via-tracing
-    # An example input you would normally provide to your model's forward() method.
-    example = torch.rand(1, 3, 224, 224)
-
     # Use torch.jit.trace to generate a torch.jit.ScriptModule via tracing.
     traced_script_module = torch.jit.trace(model, example)
 
@@ -25,7 +24,48 @@ def main():
     filename = "resnet18_scriptmodule.pt"
     traced_script_module.save(filename)
     print(f"Successfully created scriptmodule file {filename}.")
+    return model
+
+
+def export_int8(fp32_model, example, calibration_batches):
+    # Post-training static quantization: conv and linear layers run in int8 (fbgemm, x86).
+    # Dynamic quantization would only cover the final Linear layer of a ResNet.
+    torch.backends.quantized.engine = "fbgemm"
+    model = torchvision.models.quantization.resnet18(pretrained=False, quantize=False)
+    model.fc = torch.nn.Linear(model.fc.in_features, 100)
+    # Same weights as the fp32 export, so top-1 agreement can be compared in C++
+    model.load_state_dict(fp32_model.state_dict())
+    model.eval()
+
+    model.fuse_model()
+    model.qconfig = torch.ao.quantization.get_default_qconfig("fbgemm")
+    torch.ao.quantization.prepare(model, inplace=True)
+
+    # Calibrate activation ranges; replace with real images for production accuracy
+    with torch.no_grad():
+        for _ in range(calibration_batches):
+            model(torch.randn(8, 3, 224, 224))
+    torch.ao.quantization.convert(model, inplace=True)
+
+    traced_script_module = torch.jit.trace(model, example)
+    filename = "resnet18_int8_scriptmodule.pt"
+    traced_script_module.save(filename)
+    print(f"Successfully created scriptmodule file {filename}.")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Export ResNet-18 TorchScript modules for the C++ examples.")
+    parser.add_argument("--int8", action="store_true", help="also export a statically quantized int8 module")
+    parser.add_argument("--calibration-batches", type=int, default=16)
+    args = parser.parse_args()
+
+    # An example input you would normally provide to your model's forward() method.
+    example = torch.rand(1, 3, 224, 224)
+
+    model = export_fp32(example)
+    if args.int8:
+        export_int8(model.eval(), example, args.calibration_batches)
 
 
 if __name__ == "__main__":
-    main()
\ No newline at end of file
+    main()
@@ -0,0 +1,503 @@
+#include "db/access/cell_rollup.hpp"
+#include "internal/cass_helpers.hpp"
+#include "internal/hash.hpp"
+#include "trace/trace.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+using internal::future_error;
+using internal::mix;
+
+namespace
+{
+    // Magnitudes below this count as zero
+    constexpr double min_magnitude = 1e-9;
+
+    template <typename T>
+    void put(std::string &out, T value)
+    {
+        out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    T take(const std::string &in, size_t &pos)
+    {
+        if (pos + sizeof(T) > in.size())
+            throw std::invalid_argument("quantile_sketch::deserialize: truncated input");
+        T value;
+        std::memcpy(&value, in.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    void put_bins(std::string &out, const std::map<int32_t, uint64_t> &bins)
+    {
+        put<uint32_t>(out, (uint32_t)bins.size());
+        for (const auto &bin : bins)
+        {
+            put<int32_t>(out, bin.first);
+            put<uint64_t>(out, bin.second);
+        }
+    }
+
+    uint64_t take_bins(const std::string &in, size_t &pos, std::map<int32_t, uint64_t> &bins)
+    {
+        uint64_t total = 0;
+        uint32_t size = take<uint32_t>(in, pos);
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            int32_t index = take<int32_t>(in, pos);
+            uint64_t count = take<uint64_t>(in, pos);
+            bins[index] += count;
+            total += count;
+        }
+        return total;
+    }
+
+    int64_t get_int64(const CassRow *row, const char *name)
+    {
+        int64_t value = 0;
+        cass_value_get_int64(cass_row_get_column_by_name(row, name), &value);
+        return value;
+    }
+
+    double get_double(const CassRow *row, const char *name)
+    {
+        double value = 0;
+        cass_value_get_double(cass_row_get_column_by_name(row, name), &value);
+        return value;
+    }
+
+    const char *insert_rollup_cql =
+        "INSERT INTO cell_rollups (mcc, mnc, lac, cellid, bucket_start, flush_id, samples, signal_count, "
+        "signal_sum, signal_min, signal_max, first_seen, last_seen, signal_sketch) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+
+    const char *select_rollups_cql =
+        "SELECT bucket_start, samples, signal_count, signal_sum, signal_min, signal_max, first_seen, last_seen, "
+        "signal_sketch FROM cell_rollups WHERE mcc = ? AND mnc = ? AND lac = ? AND cellid = ? "
+        "AND bucket_start >= ? AND bucket_start < ?";
+}
+
+quantile_sketch::quantile_sketch(double relative_accuracy) : accuracy(relative_accuracy), zeros(0), n(0)
+{
+    if (!(relative_accuracy > 0 && relative_accuracy < 1))
+        throw std::invalid_argument("quantile_sketch accuracy must be in (0, 1)");
+    gamma = (1 + accuracy) / (1 - accuracy);
+    log_gamma = std::log(gamma);
+}
+
+int32_t quantile_sketch::bin_of(double magnitude) const
+{
+    return (int32_t)std::ceil(std::log(magnitude) / log_gamma);
+}
+
+double quantile_sketch::value_of(int32_t bin) const
+{
+    // Midpoint of (γ^(i-1), γ^i] in relative terms
+    return 2 * std::pow(gamma, bin) / (gamma + 1);
+}
+
+void quantile_sketch::add(double value)
+{
+    if (std::isnan(value))
+        return;
+    if (std::abs(value) < min_magnitude)
+        ++zeros;
+    else if (value > 0)
+        ++positive[bin_of(value)];
+    else
+        ++negative[bin_of(-value)];
+    ++n;
+}
+
+void quantile_sketch::merge(const quantile_sketch &other)
+{
+    if (other.accuracy != accuracy)
+        throw std::invalid_argument("quantile_sketch::merge: sketches have different accuracy");
+    for (const auto &bin : other.positive)
+        positive[bin.first] += bin.second;
+    for (const auto &bin : other.negative)
+        negative[bin.first] += bin.second;
+    zeros += other.zeros;
+    n += other.n;
+}
+
+double quantile_sketch::quantile(double q) const
+{
+    if (n == 0)
+        return std::numeric_limits<double>::quiet_NaN();
+    q = std::min(1.0, std::max(0.0, q));
+    const uint64_t rank = (uint64_t)std::floor(q * (double)(n - 1));
+
+    // Ascending order: most negative values (largest magnitude bins) first
+    uint64_t seen = 0;
+    for (auto it = negative.rbegin(); it != negative.rend(); ++it)
+    {
+        seen += it->second;
+        if (seen > rank)
+            return -value_of(it->first);
+    }
+    seen += zeros;
+    if (seen > rank)
+        return 0;
+    for (const auto &bin : positive)
+    {
+        seen += bin.second;
+        if (seen > rank)
+            return value_of(bin.first);
+    }
+    return value_of(positive.rbegin()->first);
+}
+
+std::string quantile_sketch::serialize() const
+{
+    std::string out;
+    out.reserve(24 + 12 * (positive.size() + negative.size()));
+    put<double>(out, accuracy);
+    put<uint64_t>(out, zeros);
+    put_bins(out, positive);
+    put_bins(out, negative);
+    return out;
+}
+
+quantile_sketch quantile_sketch::deserialize(const std::string &bytes)
+{
+    size_t pos = 0;
+    quantile_sketch sketch(take<double>(bytes, pos));
+    sketch.zeros = take<uint64_t>(bytes, pos);
+    sketch.n = sketch.zeros;
+    sketch.n += take_bins(bytes, pos, sketch.positive);
+    sketch.n += take_bins(bytes, pos, sketch.negative);
+    return sketch;
+}
+
+void rollup_aggregate::add(int64_t measured_at, bool has_signal, int32_t signal)
+{
+    first_seen = samples ? std::min(first_seen, measured_at) : measured_at;
+    last_seen = samples ? std::max(last_seen, measured_at) : measured_at;
+    ++samples;
+
+    if (has_signal)
+    {
+        signal_min = signal_count ? std::min(signal_min, (double)signal) : signal;
+        signal_max = signal_count ? std::max(signal_max, (double)signal) : signal;
+        signal_sum += signal;
+        ++signal_count;
+        signal_sketch.add(signal);
+    }
+}
+
+void rollup_aggregate::merge(const rollup_aggregate &other)
+{
+    if (other.samples > 0)
+    {
+        first_seen = samples ? std::min(first_seen, other.first_seen) : other.first_seen;
+        last_seen = samples ? std::max(last_seen, other.last_seen) : other.last_seen;
+        samples += other.samples;
+    }
+    if (other.signal_count > 0)
+    {
+        signal_min = signal_count ? std::min(signal_min, other.signal_min) : other.signal_min;
+        signal_max = signal_count ? std::max(signal_max, other.signal_max) : other.signal_max;
+        signal_sum += other.signal_sum;
+        signal_count += other.signal_count;
+    }
+    signal_sketch.merge(other.signal_sketch);
+}
+
+size_t rollup_aggregator::key_hash::operator()(const rollup_key &k) const
+{
+    uint64_t h = mix((uint64_t)k.cellid * 0x9E3779B97F4A7C15ULL ^ (uint64_t)k.bucket_start);
+    h = mix(h ^ ((uint64_t)(uint32_t)k.lac << 32 | (uint32_t)k.mnc) ^ ((uint64_t)(uint32_t)k.mcc << 16));
+    return (size_t)h;
+}
+
+rollup_aggregator::rollup_aggregator(rollup_options options)
+    : options(options), shards(std::max(1, options.n_shards)), flushes(0)
+{
+    if (options.bucket_ms <= 0)
+        throw std::invalid_argument("rollup_aggregator bucket width must be positive");
+    if (options.max_in_flight == 0)
+        throw std::invalid_argument("rollup_aggregator max_in_flight must be positive");
+}
+
+size_t rollup_aggregator::shard_of(const rollup_key &key) const
+{
+    return (key_hash()(key) >> 40) % shards.size();
+}
+
+int64_t rollup_aggregator::bucket_of(int64_t measured_at) const
+{
+    int64_t q = measured_at / options.bucket_ms;
+    if (measured_at % options.bucket_ms < 0)
+        --q; // floor for timestamps before the epoch
+    return q * options.bucket_ms;
+}
+
+void rollup_aggregator::add(const measurement &m)
+{
+    rollup_key key;
+    key.mcc = m.key.mcc;
+    key.mnc = m.key.mnc;
+    key.lac = m.key.lac;
+    key.cellid = m.key.cellid;
+    key.bucket_start = bucket_of(m.key.measured_at);
+    const int32_t signal = m.movement_data.signal != 0 ? m.movement_data.signal : m.stats_data.avg_signal;
+
+    auto &s = shards[shard_of(key)];
+    std::lock_guard<std::mutex> guard(s.lock);
+    s.buckets.try_emplace(key, options.sketch_accuracy).first->second.add(m.key.measured_at, signal != 0, signal);
+}
+
+void rollup_aggregator::add(const measurement_batch &batch)
+{
+    std::vector<rollup_map> buckets(shards.size());
+    rollup_key key;
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        key.mcc = batch.mcc[i];
+        key.mnc = batch.mnc[i];
+        key.lac = batch.lac[i];
+        key.cellid = batch.cellid[i];
+        const int64_t ts = batch.measured_at[i];
+        key.bucket_start = bucket_of(ts);
+        const auto &source = batch.signal.valid(i) ? batch.signal : batch.avg_signal;
+
+        buckets[shard_of(key)].try_emplace(key, options.sketch_accuracy).first->second.add(ts, source.valid(i),
+                                                                                          source.values[i]);
+    }
+    merge_local(buckets);
+}
+
+void rollup_aggregator::merge_local(std::vector<rollup_map> &buckets)
+{
+    for (size_t s = 0; s < shards.size(); ++s)
+    {
+        if (buckets[s].empty())
+            continue;
+        std::lock_guard<std::mutex> guard(shards[s].lock);
+        for (auto &entry : buckets[s])
+            shards[s].buckets.try_emplace(entry.first, options.sketch_accuracy).first->second.merge(entry.second);
+    }
+}
+
+std::vector<std::pair<rollup_key, rollup_aggregate>> rollup_aggregator::pending_buckets() const
+{
+    std::vector<std::pair<rollup_key, rollup_aggregate>> out;
+    {
+        std::lock_guard<std::mutex> guard(retry_lock);
+        for (const auto &row : retry)
+            out.emplace_back(row.key, row.aggregate);
+    }
+    for (const auto &s : shards)
+    {
+        std::lock_guard<std::mutex> guard(s.lock);
+        out.insert(out.end(), s.buckets.begin(), s.buckets.end());
+    }
+    return out;
+}
+
+size_t rollup_aggregator::flush(connector &db)
+{
+    trace_span span("rollup_aggregator::flush", "cassandra");
+
+    // 1. Swap out the pending deltas shard by shard; ingest carries on into empty maps
+    std::vector<rollup_map> taken(shards.size());
+    bool any_new = false;
+    for (size_t i = 0; i < shards.size(); ++i)
+    {
+        std::lock_guard<std::mutex> guard(shards[i].lock);
+        taken[i].swap(shards[i].buckets);
+        any_new |= !taken[i].empty();
+    }
+
+    // 2. Take the rows of failed earlier writes and number this flush. The flush_id is unique
+    //    per flush, so rows from different flushes of the same bucket never overwrite each
+    //    other; with a source_id it is also the same on every run over the same input.
+    std::vector<written_row> rows;
+    int64_t flush_id = 0;
+    {
+        std::lock_guard<std::mutex> guard(retry_lock);
+        rows.swap(retry);
+        if (any_new)
+        {
+            if (options.source_id != 0)
+                flush_id = (int64_t)mix(options.source_id ^ mix(++flushes));
+            else
+            {
+                ++flushes;
+                std::random_device device;
+                flush_id = (int64_t)mix(((uint64_t)device() << 32 | device()) ^ (uint64_t)tracer::now_ns());
+            }
+        }
+    }
+    for (auto &map : taken)
+        for (auto &entry : map)
+            rows.push_back({entry.first, std::move(entry.second), flush_id});
+    if (rows.empty())
+        return 0;
+
+    auto keep_for_retry = [&](const std::vector<size_t> &failed) {
+        std::lock_guard<std::mutex> guard(retry_lock);
+        for (size_t r : failed)
+            retry.push_back(rows[r]);
+    };
+
+    const CassPrepared *prepared;
+    try
+    {
+        prepared = db.prepare_query(insert_rollup_cql);
+    }
+    catch (...)
+    {
+        std::vector<size_t> all(rows.size());
+        for (size_t r = 0; r < all.size(); ++r)
+            all[r] = r;
+        keep_for_retry(all);
+        throw;
+    }
+
+    // 3. Write every row, keeping at most max_in_flight requests outstanding
+    std::deque<std::pair<CassFuture *, size_t>> in_flight;
+    std::vector<size_t> failed;
+    std::string first_error;
+
+    auto finish_oldest = [&]() {
+        auto oldest = in_flight.front();
+        in_flight.pop_front();
+        cass_future_wait(oldest.first);
+        if (cass_future_error_code(oldest.first) != CASS_OK)
+        {
+            if (first_error.empty())
+                first_error = future_error(oldest.first);
+            failed.push_back(oldest.second);
+        }
+        cass_future_free(oldest.first);
+    };
+
+    for (size_t r = 0; r < rows.size(); ++r)
+    {
+        const rollup_key &k = rows[r].key;
+        const rollup_aggregate &a = rows[r].aggregate;
+        std::string sketch = a.signal_sketch.serialize();
+
+        CassStatement *statement = cass_prepared_bind(prepared);
+        cass_statement_bind_int32_by_name(statement, columns.mcc, k.mcc);
+        cass_statement_bind_int32_by_name(statement, columns.mnc, k.mnc);
+        cass_statement_bind_int32_by_name(statement, columns.lac, k.lac);
+        cass_statement_bind_int64_by_name(statement, columns.cellid, k.cellid);
+        cass_statement_bind_int64_by_name(statement, "bucket_start", k.bucket_start);
+        cass_statement_bind_int64_by_name(statement, "flush_id", rows[r].flush_id);
+        cass_statement_bind_int64_by_name(statement, "samples", a.samples);
+        cass_statement_bind_int64_by_name(statement, "signal_count", a.signal_count);
+        cass_statement_bind_double_by_name(statement, "signal_sum", a.signal_sum);
+        cass_statement_bind_double_by_name(statement, "signal_min", a.signal_min);
+        cass_statement_bind_double_by_name(statement, "signal_max", a.signal_max);
+        cass_statement_bind_int64_by_name(statement, "first_seen", a.first_seen);
+        cass_statement_bind_int64_by_name(statement, "last_seen", a.last_seen);
+        cass_statement_bind_bytes_by_name(statement, "signal_sketch", (const cass_byte_t *)sketch.data(),
+                                          sketch.size());
+
+        in_flight.emplace_back(cass_session_execute(db.get_session(), statement), r);
+        cass_statement_free(statement);
+
+        if (in_flight.size() >= options.max_in_flight)
+            finish_oldest();
+    }
+    while (!in_flight.empty())
+        finish_oldest();
+    cass_prepared_free(prepared);
+
+    // 4. Failed rows are kept as they are for the next flush
+    if (!failed.empty())
+    {
+        keep_for_retry(failed);
+        throw std::runtime_error("Rollup flush failed for " + std::to_string(failed.size()) + " of " +
+                                 std::to_string(rows.size()) + " rows: " + first_error);
+    }
+    return rows.size();
+}
+
+std::vector<std::pair<int64_t, rollup_aggregate>> rollup_aggregator::load(connector &db, int32_t mcc, int32_t mnc,
+                                                                          int32_t lac, int64_t cellid,
+                                                                          int64_t from_ms, int64_t to_ms)
+{
+    trace_span span("rollup_aggregator::load", "cassandra");
+    const CassPrepared *prepared = db.prepare_query(select_rollups_cql);
+    CassStatement *statement = cass_prepared_bind(prepared);
+    cass_statement_bind_int32_by_name(statement, columns.mcc, mcc);
+    cass_statement_bind_int32_by_name(statement, columns.mnc, mnc);
+    cass_statement_bind_int32_by_name(statement, columns.lac, lac);
+    cass_statement_bind_int64_by_name(statement, columns.cellid, cellid);
+    // Both bounds bind to bucket_start, so bind by position
+    cass_statement_bind_int64(statement, 4, from_ms);
+    cass_statement_bind_int64(statement, 5, to_ms);
+
+    std::map<int64_t, rollup_aggregate> merged;
+    bool more_pages = true;
+    while (more_pages)
+    {
+        CassFuture *future = cass_session_execute(db.get_session(), statement);
+        cass_future_wait(future);
+        if (cass_future_error_code(future) != CASS_OK)
+        {
+            std::string error = future_error(future);
+            cass_future_free(future);
+            cass_statement_free(statement);
+            cass_prepared_free(prepared);
+            throw std::runtime_error("Error loading rollups: " + error);
+        }
+
+        const CassResult *result = cass_future_get_result(future);
+        CassIterator *iterator = cass_iterator_from_result(result);
+        while (cass_iterator_next(iterator))
+        {
+            const CassRow *row = cass_iterator_get_row(iterator);
+            const cass_byte_t *bytes = nullptr;
+            size_t size = 0;
+            cass_value_get_bytes(cass_row_get_column_by_name(row, "signal_sketch"), &bytes, &size);
+
+            rollup_aggregate a;
+            a.signal_sketch = quantile_sketch::deserialize(std::string((const char *)bytes, size));
+            a.samples = get_int64(row, "samples");
+            a.signal_count = get_int64(row, "signal_count");
+            a.signal_sum = get_double(row, "signal_sum");
+            a.signal_min = get_double(row, "signal_min");
+            a.signal_max = get_double(row, "signal_max");
+            a.first_seen = get_int64(row, "first_seen");
+            a.last_seen = get_int64(row, "last_seen");
+
+            int64_t bucket_start = get_int64(row, "bucket_start");
+            merged.try_emplace(bucket_start, a.signal_sketch.relative_accuracy()).first->second.merge(a);
+        }
+        cass_iterator_free(iterator);
+
+        more_pages = cass_result_has_more_pages(result);
+        if (more_pages)
+            cass_statement_set_paging_state(statement, result);
+        cass_result_free(result);
+        cass_future_free(future);
+    }
+
+    cass_statement_free(statement);
+    cass_prepared_free(prepared);
+    return std::vector<std::pair<int64_t, rollup_aggregate>>(merged.begin(), merged.end());
+}
+
+rollup_aggregate rollup_aggregator::load_cell(connector &db, int32_t mcc, int32_t mnc, int32_t lac, int64_t cellid)
+{
+    auto buckets = load(db, mcc, mnc, lac, cellid, std::numeric_limits<int64_t>::min(),
+                        std::numeric_limits<int64_t>::max());
+    if (buckets.empty())
+        return rollup_aggregate();
+    rollup_aggregate total(buckets.front().second.signal_sketch.relative_accuracy());
+    for (const auto &bucket : buckets)
+        total.merge(bucket.second);
+    return total;
+}
@@ -1,8 +1,25 @@
 #include "db/access/measurement.hpp"
+#include "db/access/cell_rollup.hpp"
+#include "db/access/measurement_batch.hpp"
 #include "db/connector.hpp"
+#include "internal/cass_helpers.hpp"
+#include "trace/trace.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <map>
+#include <queue>
+#include <unordered_map>
+
+using internal::future_error;
 
 void measurement_manager::insert(const measurement &m)
 {
+    trace_span span("measurement_manager::insert", "cassandra");
     if (m.key.mcc == 0 || m.key.mnc == 0 || m.key.lac == 0 || m.key.cellid == 0 || m.key.measured_at == 0)
     {
         json j_keys;
@@ -12,8 +29,13 @@ void measurement_manager::insert(const measurement &m)
     }
 
     int field_count = 5; // Start with required fields
-    std::string cql = "INSERT INTO measurements ( ";
+    std::string cql = "INSERT INTO " + std::string(layout.table()) + " ( ";
     cql += "mcc, mnc, lac, cellid, measured_at, ";
+    if (layout.bucketed)
+    {
+        cql += "lac_bucket, day, ";
+        field_count += 2;
+    }
     if (m.core_data.lat != 0)
     {
         cql += "lat, ";
@@ -138,6 +160,7 @@ void measurement_manager::insert(const measurement &m)
     cass_statement_bind_int32_by_name(statement, columns.lac, m.key.lac);
     cass_statement_bind_int64_by_name(statement, columns.cellid, m.key.cellid);
     cass_statement_bind_int64_by_name(statement, columns.measured_at, m.key.measured_at);
+    bind_bucket(statement, m.key.lac, m.key.measured_at);
 
     if (m.core_data.lat != 0)
         cass_statement_bind_double_by_name(statement, columns.lat, m.core_data.lat);
@@ -184,8 +207,13 @@ void measurement_manager::insert(const measurement &m)
     if (m.tech.bid != 0)
         cass_statement_bind_int32_by_name(statement, columns.bid, m.tech.bid);
 
+    if (layout.bucketed)
+        record_buckets({bucket_id(m.key.mcc, m.key.mnc, layout.lac_bucket(m.key.lac), layout.day(m.key.measured_at))});
+
     CassFuture *future = cass_session_execute(db.get_session(), statement);
     cass_future_wait(future);
+    if (rollups && cass_future_error_code(future) == CASS_OK)
+        rollups->add(m);
 
     cass_statement_free(statement);
     cass_prepared_free(prepared);
@@ -194,13 +222,15 @@ void measurement_manager::insert(const measurement &m)
 
 measurement measurement_manager::get_measurement(int32_t mcc, int32_t mnc, int32_t lac, int32_t cellid, int64_t ts)
 {
-    std::string query = "SELECT * FROM measurements WHERE mcc = ? AND mnc = ? AND lac = ? AND cellid = ? AND measured_at = ?";
-    CassStatement *statement = cass_statement_new(query.c_str(), 5);
+    trace_span span("measurement_manager::get_measurement", "cassandra");
+    std::string query = "SELECT * FROM " + std::string(layout.table()) + " WHERE " + row_clause();
+    CassStatement *statement = cass_statement_new(query.c_str(), layout.bucketed ? 7 : 5);
     cass_statement_bind_int32_by_name(statement, columns.mcc, mcc);
     cass_statement_bind_int32_by_name(statement, columns.mnc, mnc);
     cass_statement_bind_int32_by_name(statement, columns.lac, lac);
     cass_statement_bind_int64_by_name(statement, columns.cellid, cellid);
     cass_statement_bind_int64_by_name(statement, columns.measured_at, ts);
+    bind_bucket(statement, lac, ts);
     CassFuture *future = cass_session_execute(db.get_session(), statement);
     cass_future_wait(future);
 
@@ -287,6 +317,11 @@ measurement measurement_manager::get_measurement(int32_t mcc, int32_t mnc, int32
 
 std::vector<measurement> measurement_manager::get_measurements(int32_t mcc, int32_t mnc)
 {
+    trace_span span("measurement_manager::get_measurements", "cassandra");
+    // An operator spans many partitions in the bucketed layout
+    if (layout.bucketed)
+        return get_measurement_batch(mcc, mnc).to_rows();
+
     std::vector<measurement> results;
     std::string query = "SELECT * FROM measurements WHERE mcc = ? AND mnc = ?";
 
@@ -385,14 +420,16 @@ std::vector<measurement> measurement_manager::get_measurements(int32_t mcc, int3
 
 void measurement_manager::update_signal(int32_t mcc, int32_t mnc, int32_t lac, int32_t cellid, int64_t ts, int32_t new_signal)
 {
-    std::string query = "UPDATE measurements SET signal = ? WHERE mcc = ? AND mnc = ? AND lac = ? AND cellid = ? AND measured_at = ?";
-    CassStatement *statement = cass_statement_new(query.c_str(), 6);
+    trace_span span("measurement_manager::update_signal", "cassandra");
+    std::string query = "UPDATE " + std::string(layout.table()) + " SET signal = ? WHERE " + row_clause();
+    CassStatement *statement = cass_statement_new(query.c_str(), layout.bucketed ? 8 : 6);
     cass_statement_bind_int32_by_name(statement, columns.signal, new_signal);
     cass_statement_bind_int32_by_name(statement, columns.mcc, mcc);
     cass_statement_bind_int32_by_name(statement, columns.mnc, mnc);
     cass_statement_bind_int32_by_name(statement, columns.lac, lac);
     cass_statement_bind_int64_by_name(statement, columns.cellid, cellid);
     cass_statement_bind_int64_by_name(statement, columns.measured_at, ts);
+    bind_bucket(statement, lac, ts);
     CassFuture *future = cass_session_execute(db.get_session(), statement);
     cass_future_wait(future);
     cass_future_free(future);
@@ -401,21 +438,34 @@ void measurement_manager::update_signal(int32_t mcc, int32_t mnc, int32_t lac, i
 
 void measurement_manager::remove(int32_t mcc, int32_t mnc, int32_t lac, int32_t cellid, int64_t ts)
 {
-    std::string query = "DELETE FROM measurements WHERE mcc = ? AND mnc = ? AND lac = ? AND cellid = ? AND measured_at = ?";
-    CassStatement *statement = cass_statement_new(query.c_str(), 5);
+    trace_span span("measurement_manager::remove", "cassandra");
+    std::string query = "DELETE FROM " + std::string(layout.table()) + " WHERE " + row_clause();
+    CassStatement *statement = cass_statement_new(query.c_str(), layout.bucketed ? 7 : 5);
     cass_statement_bind_int32_by_name(statement, columns.mcc, mcc);
     cass_statement_bind_int32_by_name(statement, columns.mnc, mnc);
     cass_statement_bind_int32_by_name(statement, columns.lac, lac);
     cass_statement_bind_int64_by_name(statement, columns.cellid, cellid);
     cass_statement_bind_int64_by_name(statement, columns.measured_at, ts);
+    bind_bucket(statement, lac, ts);
     CassFuture *future = cass_session_execute(db.get_session(), statement);
     cass_future_wait(future);
     cass_future_free(future);
     cass_statement_free(statement);
 }
 
-core measurement_manager::get_tower_location(int32_t mcc, int32_t mnc, int32_t lac, int32_t cellid)
+core measurement_manager::get_tower_location(int32_t mcc, int32_t mnc, int32_t lac, int64_t cellid)
 {
+    trace_span span("measurement_manager::get_tower_location", "cassandra");
+    if (layout.bucketed)
+    {
+        keys k;
+        k.mcc = mcc;
+        k.mnc = mnc;
+        k.lac = lac;
+        k.cellid = cellid;
+        return get_tower_locations({k}).front();
+    }
+
     std::string query = "SELECT lat, lon, rating, range FROM measurements WHERE mcc = ? AND mnc = ? AND lac = ? AND cellid = ? LIMIT 1";
     CassStatement *statement = cass_statement_new(query.c_str(), 4);
     cass_statement_bind_int32_by_name(statement, columns.mcc, mcc);
@@ -424,31 +474,1361 @@ core measurement_manager::get_tower_location(int32_t mcc, int32_t mnc, int32_t l
     cass_statement_bind_int64_by_name(statement, columns.cellid, cellid);
     CassFuture *future = cass_session_execute(db.get_session(), statement);
     cass_future_wait(future);
+    cass_statement_free(statement);
+    if (cass_future_error_code(future) != CASS_OK)
+    {
+        std::string error = future_error(future);
+        cass_future_free(future);
+        throw std::runtime_error("Error fetching tower location: " + error);
+    }
+
     core c;
-    if (cass_future_error_code(future) == CASS_OK)
+    const CassResult *result = cass_future_get_result(future);
+    if (cass_result_row_count(result) > 0)
+    {
+        const CassRow *row = cass_result_first_row(result);
+        cass_value_get_double(cass_row_get_column_by_name(row, columns.lat), &c.lat);
+        cass_value_get_double(cass_row_get_column_by_name(row, columns.lon), &c.lon);
+        cass_value_get_double(cass_row_get_column_by_name(row, columns.rating), &c.rating);
+        cass_value_get_int32(cass_row_get_column_by_name(row, columns.range), &c.range);
+    }
+    cass_result_free(result);
+    cass_future_free(future);
+    return c;
+}
+
+namespace
+{
+    // Bound in flight at once by a batch insert
+    constexpr size_t max_in_flight = 256;
+
+    // Statements per unlogged batch of single-partition updates
+    constexpr size_t max_batch_rows = 100;
+
+    // Partitions read at once by a fan-out read; each may hold a page of rows in memory
+    constexpr size_t max_reads_in_flight = 32;
+
+    // Rows a streaming fan-out read holds back for partitions ahead of the one it delivers
+    constexpr size_t max_held_rows = 100000;
+
+    CassError bind_value(CassStatement *statement, const char *name, int32_t value)
+    {
+        return cass_statement_bind_int32_by_name(statement, name, value);
+    }
+
+    CassError bind_value(CassStatement *statement, const char *name, int64_t value)
     {
+        return cass_statement_bind_int64_by_name(statement, name, value);
+    }
+
+    CassError bind_value(CassStatement *statement, const char *name, double value)
+    {
+        return cass_statement_bind_double_by_name(statement, name, value);
+    }
+
+    // A non-key column of a batch: its name, validity and how to bind row i
+    struct optional_field {
+        const char *name;
+        const validity_bitmap *validity;
+        std::function<void(CassStatement *, size_t)> bind;
+    };
+
+    template <typename T>
+    optional_field field(const char *name, const column<T> &c)
+    {
+        return {name, &c.validity, [&c, name](CassStatement *s, size_t i) { bind_value(s, name, c.values[i]); }};
+    }
+
+    optional_field field(const char *name, const dictionary_column &c)
+    {
+        return {name, &c.codes.validity, [&c, name](CassStatement *s, size_t i) {
+                    const std::string &value = c.at(i);
+                    cass_statement_bind_string_by_name_n(s, name, std::strlen(name), value.data(), value.size());
+                }};
+    }
+
+    std::vector<optional_field> optional_fields(const measurement_batch &b)
+    {
+        return {field(columns.lat, b.lat),
+                field(columns.lon, b.lon),
+                field(columns.rating, b.rating),
+                field(columns.range, b.range),
+                field(columns.apikey, b.apikey),
+                field(columns.radio, b.radio),
+                field(columns.devn, b.devn),
+                field(columns.unit, b.unit),
+                field(columns.samples, b.samples),
+                field(columns.changeable, b.changeable),
+                field(columns.avg_signal, b.avg_signal),
+                field(columns.created_at, b.created_at),
+                field(columns.updated_at, b.updated_at),
+                field(columns.signal, b.signal),
+                field(columns.speed, b.speed),
+                field(columns.direction, b.direction),
+                field(columns.ta, b.ta),
+                field(columns.tac, b.tac),
+                field(columns.pci, b.pci),
+                field(columns.sid, b.sid),
+                field(columns.nid, b.nid),
+                field(columns.bid, b.bid)};
+    }
+
+    // INSERT listing the keys plus every optional field whose bit is set in 'mask'
+    std::string insert_cql(const measurement_layout &layout, const std::vector<optional_field> &fields,
+                           uint32_t mask)
+    {
+        std::string cql = "INSERT INTO " + std::string(layout.table()) + " (mcc, mnc, lac, cellid, measured_at";
+        std::string values = "?, ?, ?, ?, ?";
+        if (layout.bucketed)
+        {
+            cql += ", lac_bucket, day";
+            values += ", ?, ?";
+        }
+        for (size_t f = 0; f < fields.size(); ++f)
+        {
+            if (mask & (1u << f))
+            {
+                cql += ", ";
+                cql += fields[f].name;
+                values += ", ?";
+            }
+        }
+        return cql + ") VALUES (" + values + ")";
+    }
+
+    bool get_value(const CassValue *value, int32_t *out)
+    {
+        return cass_value_get_int32(value, out) == CASS_OK;
+    }
+
+    bool get_value(const CassValue *value, int64_t *out)
+    {
+        return cass_value_get_int64(value, out) == CASS_OK;
+    }
+
+    bool get_value(const CassValue *value, double *out)
+    {
+        return cass_value_get_double(value, out) == CASS_OK;
+    }
+
+    template <typename T>
+    void read_key(const CassRow *row, const char *name, std::vector<T> &out)
+    {
+        T value = 0;
+        get_value(cass_row_get_column_by_name(row, name), &value);
+        out.push_back(value);
+    }
+
+    // A missing column (not selected) or a null value both become a null
+    template <typename T>
+    void read_column(const CassRow *row, const char *name, column<T> &out)
+    {
+        const CassValue *value = cass_row_get_column_by_name(row, name);
+        T v;
+        if (value != nullptr && !cass_value_is_null(value) && get_value(value, &v))
+            out.push_back(v);
+        else
+            out.push_null();
+    }
+
+    void read_column(const CassRow *row, const char *name, dictionary_column &out)
+    {
+        const CassValue *value = cass_row_get_column_by_name(row, name);
+        const char *ptr;
+        size_t len;
+        if (value != nullptr && !cass_value_is_null(value) && cass_value_get_string(value, &ptr, &len) == CASS_OK)
+            out.push_back(std::string(ptr, len));
+        else
+            out.push_null();
+    }
+
+    void read_row(const CassRow *row, measurement_batch &b)
+    {
+        read_key(row, columns.mcc, b.mcc);
+        read_key(row, columns.mnc, b.mnc);
+        read_key(row, columns.lac, b.lac);
+        read_key(row, columns.cellid, b.cellid);
+        read_key(row, columns.measured_at, b.measured_at);
+
+        read_column(row, columns.lat, b.lat);
+        read_column(row, columns.lon, b.lon);
+        read_column(row, columns.rating, b.rating);
+        read_column(row, columns.range, b.range);
+
+        read_column(row, columns.radio, b.radio);
+        read_column(row, columns.apikey, b.apikey);
+        read_column(row, columns.devn, b.devn);
+
+        read_column(row, columns.unit, b.unit);
+        read_column(row, columns.samples, b.samples);
+        read_column(row, columns.changeable, b.changeable);
+        read_column(row, columns.avg_signal, b.avg_signal);
+        read_column(row, columns.created_at, b.created_at);
+        read_column(row, columns.updated_at, b.updated_at);
+
+        read_column(row, columns.signal, b.signal);
+        read_column(row, columns.speed, b.speed);
+        read_column(row, columns.direction, b.direction);
+
+        read_column(row, columns.ta, b.ta);
+        read_column(row, columns.tac, b.tac);
+        read_column(row, columns.pci, b.pci);
+        read_column(row, columns.sid, b.sid);
+        read_column(row, columns.nid, b.nid);
+        read_column(row, columns.bid, b.bid);
+    }
+
+    // Frees a statement on every exit path
+    struct statement_guard {
+        CassStatement *statement;
+
+        explicit statement_guard(CassStatement *statement) : statement(statement) {}
+
+        ~statement_guard() { cass_statement_free(statement); }
+    };
+
+    // Waits for one page of 'statement' and appends its rows to 'batch'. When more pages
+    // follow, the statement is moved on to the next page, its token is stored in
+    // 'paging_state' (if given) and true is returned. Frees the future.
+    bool read_page(CassFuture *future, CassStatement *statement, measurement_batch &batch,
+                   std::string *paging_state)
+    {
+        cass_future_wait(future);
+        if (cass_future_error_code(future) != CASS_OK)
+        {
+            std::string error = future_error(future);
+            cass_future_free(future);
+            throw std::runtime_error("Error fetching measurements: " + error);
+        }
+
         const CassResult *result = cass_future_get_result(future);
-        if (cass_result_row_count(result) > 0)
+        batch.reserve(batch.size() + cass_result_row_count(result));
+        CassIterator *iterator = cass_iterator_from_result(result);
+        while (cass_iterator_next(iterator))
+            read_row(cass_iterator_get_row(iterator), batch);
+        cass_iterator_free(iterator);
+
+        bool more_pages = cass_result_has_more_pages(result);
+        if (paging_state)
+            paging_state->clear();
+        if (more_pages)
         {
-            const CassRow *row = cass_result_first_row(result);
-            cass_value_get_double(cass_row_get_column_by_name(row, columns.lat), &c.lat);
-            cass_value_get_double(cass_row_get_column_by_name(row, columns.lon), &c.lon);
-            cass_value_get_double(cass_row_get_column_by_name(row, columns.rating), &c.rating);
-            cass_value_get_int32(cass_row_get_column_by_name(row, columns.range), &c.range);
+            cass_statement_set_paging_state(statement, result);
+            if (paging_state)
+            {
+                const char *token;
+                size_t token_length;
+                cass_result_paging_state_token(result, &token, &token_length);
+                paging_state->assign(token, token_length);
+            }
+        }
+        cass_result_free(result);
+        cass_future_free(future);
+        return more_pages;
+    }
+
+    bool fetch_page(CassSession *session, CassStatement *statement, measurement_batch &batch,
+                    std::string *paging_state)
+    {
+        return read_page(cass_session_execute(session, statement), statement, batch, paging_state);
+    }
+
+    // Reads every page of each statement, with at most 'window' requests in flight, and
+    // returns one batch per statement in statement order. Takes ownership of the statements.
+    std::vector<measurement_batch> read_partitions(CassSession *session, const std::vector<CassStatement *> &statements,
+                                                   size_t window)
+    {
+        std::vector<measurement_batch> parts(statements.size());
+        std::vector<CassFuture *> futures(statements.size(), nullptr);
+        std::deque<size_t> active;
+        size_t next = 0;
+        std::string first_error;
+
+        auto start = [&](size_t i) {
+            futures[i] = cass_session_execute(session, statements[i]);
+            active.push_back(i);
+        };
+        while (next < statements.size() && active.size() < window)
+            start(next++);
+
+        // Round robin over the active reads: a partition with more pages goes to the back of
+        // the queue with its next page already requested
+        while (!active.empty())
+        {
+            size_t i = active.front();
+            active.pop_front();
+            bool more_pages = false;
+            try
+            {
+                more_pages = read_page(futures[i], statements[i], parts[i], nullptr);
+            }
+            catch (const std::runtime_error &e)
+            {
+                if (first_error.empty())
+                    first_error = e.what();
+            }
+            if (!first_error.empty())
+                continue;
+            if (more_pages)
+                start(i);
+            else if (next < statements.size())
+                start(next++);
+        }
+
+        for (CassStatement *statement : statements)
+            cass_statement_free(statement);
+        if (!first_error.empty())
+            throw std::runtime_error(first_error);
+        return parts;
+    }
+
+    // Reads every page of each statement, with at most 'window' requests in flight, and hands
+    // the pages to 'consume' in statement order as they arrive. Pages of statements ahead of
+    // the one being delivered are held back until its turn; once max_held_rows are held such
+    // a statement requests no further page until then. 'consume' returns false to stop.
+    // Takes ownership of the statements.
+    void stream_partitions(CassSession *session, const std::vector<CassStatement *> &statements, size_t window,
+                           const std::function<bool(const measurement_batch &)> &consume)
+    {
+        const size_t n = statements.size();
+        std::vector<CassFuture *> futures(n, nullptr);
+        std::vector<std::deque<measurement_batch>> held(n);
+        std::vector<char> done(n, 0), parked(n, 0);
+        std::deque<size_t> active;
+        size_t next = 0, current = 0, held_rows = 0;
+        bool stopped = false;
+        std::string first_error;
+        std::exception_ptr consume_error;
+
+        auto start = [&](size_t i) {
+            futures[i] = cass_session_execute(session, statements[i]);
+            active.push_back(i);
+        };
+        auto deliver = [&](const measurement_batch &page) {
+            if (stopped || page.empty())
+                return;
+            try
+            {
+                stopped = !consume(page);
+            }
+            catch (...)
+            {
+                consume_error = std::current_exception();
+                stopped = true;
+            }
+        };
+        while (next < n && active.size() < window)
+            start(next++);
+
+        while (!active.empty())
+        {
+            size_t i = active.front();
+            active.pop_front();
+            if (stopped || !first_error.empty())
+            {
+                // Drain what is still in flight
+                cass_future_wait(futures[i]);
+                cass_future_free(futures[i]);
+                continue;
+            }
+
+            measurement_batch page;
+            bool more_pages = false;
+            try
+            {
+                more_pages = read_page(futures[i], statements[i], page, nullptr);
+            }
+            catch (const std::runtime_error &e)
+            {
+                first_error = e.what();
+                continue;
+            }
+
+            if (i == current)
+            {
+                deliver(page);
+            }
+            else
+            {
+                held_rows += page.size();
+                held[i].push_back(std::move(page));
+            }
+
+            if (!more_pages)
+            {
+                done[i] = 1;
+                if (next < n)
+                    start(next++);
+            }
+            else if (i == current || held_rows < max_held_rows)
+            {
+                start(i);
+            }
+            else
+            {
+                parked[i] = 1;
+            }
+
+            // Move on past finished statements: the next one delivers what it holds and
+            // resumes if it was parked
+            while (current < n && done[current])
+            {
+                if (++current == n)
+                    break;
+                for (const auto &held_page : held[current])
+                {
+                    held_rows -= held_page.size();
+                    deliver(held_page);
+                }
+                held[current].clear();
+                if (parked[current])
+                {
+                    parked[current] = 0;
+                    start(current);
+                }
+            }
+        }
+
+        for (CassStatement *statement : statements)
+            cass_statement_free(statement);
+        if (consume_error)
+            std::rethrow_exception(consume_error);
+        if (!first_error.empty())
+            throw std::runtime_error(first_error);
+    }
+
+    // Merges batches that are each ordered by (lac, cellid, measured_at), as the clustering
+    // key orders one partition, into one batch in that order
+    measurement_batch merge_ordered(const std::vector<measurement_batch> &parts)
+    {
+        using cursor = std::pair<size_t, size_t>; // (part, row)
+        auto later = [&parts](const cursor &a, const cursor &b) {
+            const measurement_batch &x = parts[a.first], &y = parts[b.first];
+            return std::make_tuple(x.lac[a.second], x.cellid[a.second], x.measured_at[a.second]) >
+                   std::make_tuple(y.lac[b.second], y.cellid[b.second], y.measured_at[b.second]);
+        };
+        std::priority_queue<cursor, std::vector<cursor>, decltype(later)> heads(later);
+
+        size_t total = 0;
+        for (size_t p = 0; p < parts.size(); ++p)
+        {
+            total += parts[p].size();
+            if (!parts[p].empty())
+                heads.push({p, 0});
+        }
+
+        measurement_batch merged;
+        merged.reserve(total);
+        while (!heads.empty())
+        {
+            cursor c = heads.top();
+            heads.pop();
+            merged.append(parts[c.first], c.second);
+            if (c.second + 1 < parts[c.first].size())
+                heads.push({c.first, c.second + 1});
+        }
+        return merged;
+    }
+
+    // Resume point of a bucketed range read: the day partition, the rows returned before
+    // it and the driver's paging token within it, packed into measurement_page::paging_state
+    struct bucket_cursor {
+        int64_t day, returned;
+        std::string token;
+
+        bucket_cursor() : day(0), returned(0) {}
+    };
+
+    std::string encode_cursor(const bucket_cursor &c)
+    {
+        std::string bytes(2 * sizeof(int64_t), '\0');
+        std::memcpy(&bytes[0], &c.day, sizeof(int64_t));
+        std::memcpy(&bytes[sizeof(int64_t)], &c.returned, sizeof(int64_t));
+        return bytes + c.token;
+    }
+
+    bucket_cursor decode_cursor(const std::string &bytes)
+    {
+        if (bytes.size() < 2 * sizeof(int64_t))
+            throw std::invalid_argument("measurement_range: invalid paging_state");
+        bucket_cursor c;
+        std::memcpy(&c.day, bytes.data(), sizeof(int64_t));
+        std::memcpy(&c.returned, bytes.data() + sizeof(int64_t), sizeof(int64_t));
+        c.token = bytes.substr(2 * sizeof(int64_t));
+        return c;
+    }
+
+    // The first 'n' rows of a batch
+    measurement_batch head(const measurement_batch &batch, size_t n)
+    {
+        measurement_batch rows;
+        rows.reserve(n);
+        for (size_t i = 0; i < n; ++i)
+            rows.append(batch, i);
+        return rows;
+    }
+
+    // Columns a range query may select besides the key columns
+    const char *const selectable_fields[] = {
+        columns.lat, columns.lon, columns.rating, columns.range, columns.apikey, columns.radio,
+        columns.devn, columns.unit, columns.samples, columns.changeable, columns.avg_signal,
+        columns.created_at, columns.updated_at, columns.signal, columns.speed, columns.direction,
+        columns.ta, columns.tac, columns.pci, columns.sid, columns.nid, columns.bid};
+
+    std::string range_cql(const measurement_layout &layout, const measurement_range &range)
+    {
+        std::string cql = "SELECT mcc, mnc, lac, cellid, measured_at";
+        if (range.fields.empty())
+        {
+            for (const char *name : selectable_fields)
+                cql += std::string(", ") + name;
+        }
+        for (const auto &field : range.fields)
+        {
+            // Only known column names ever reach the CQL text
+            bool known = false;
+            for (const char *name : selectable_fields)
+                known = known || field == name;
+            if (!known)
+                throw std::invalid_argument("Unknown measurement column: " + field);
+            cql += ", " + field;
+        }
+        cql += " FROM " + std::string(layout.table()) + " WHERE mcc = ? AND mnc = ?";
+        if (layout.bucketed)
+            cql += " AND lac_bucket = ? AND day = ?";
+        cql += " AND lac = ? AND cellid = ? AND measured_at >= ? AND measured_at < ?";
+        // Spelling out all three clustering columns is valid whichever way the table is ordered
+        cql += range.descending ? " ORDER BY lac DESC, cellid DESC, measured_at DESC"
+                                : " ORDER BY lac ASC, cellid ASC, measured_at ASC";
+        if (range.limit > 0)
+            cql += " LIMIT ?";
+        return cql;
+    }
+}
+
+measurement_manager::~measurement_manager()
+{
+    for (auto &entry : prepared_statements)
+        cass_prepared_free(entry.second);
+}
+
+const CassPrepared *measurement_manager::prepared(const std::string &cql)
+{
+    {
+        std::lock_guard<std::mutex> guard(prepared_lock);
+        auto it = prepared_statements.find(cql);
+        if (it != prepared_statements.end())
+            return it->second;
+    }
+
+    // Prepared without the lock: a round trip to the cluster must not stall threads that
+    // only look up statements already cached
+    const CassPrepared *fresh = db.prepare_query(cql);
+    std::lock_guard<std::mutex> guard(prepared_lock);
+    auto inserted = prepared_statements.emplace(cql, fresh);
+    if (!inserted.second)
+        cass_prepared_free(fresh); // another thread prepared it meanwhile
+    return inserted.first->second;
+}
+
+void measurement_manager::insert(const measurement_batch &batch)
+{
+    trace_span span("measurement_manager::insert_batch", "cassandra");
+    const size_t n = batch.size();
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (batch.mcc[i] == 0 || batch.mnc[i] == 0 || batch.lac[i] == 0 || batch.cellid[i] == 0 ||
+            batch.measured_at[i] == 0)
+        {
+            throw std::invalid_argument("Missing required key fields in batch row " + std::to_string(i));
+        }
+    }
+
+    if (layout.bucketed)
+    {
+        std::set<bucket_id> buckets;
+        for (size_t i = 0; i < n; ++i)
+            buckets.emplace(batch.mcc[i], batch.mnc[i], layout.lac_bucket(batch.lac[i]), layout.day(batch.measured_at[i]));
+        record_buckets(std::vector<bucket_id>(buckets.begin(), buckets.end()));
+    }
+
+    auto fields = optional_fields(batch);
+    std::unordered_map<uint32_t, const CassPrepared *> by_mask;
+    std::deque<CassFuture *> in_flight;
+    std::string first_error;
+
+    auto finish_oldest = [&]() {
+        CassFuture *future = in_flight.front();
+        in_flight.pop_front();
+        cass_future_wait(future);
+        if (cass_future_error_code(future) != CASS_OK && first_error.empty())
+            first_error = future_error(future);
+        cass_future_free(future);
+    };
+
+    try
+    {
+        for (size_t i = 0; i < n && first_error.empty(); ++i)
+        {
+            uint32_t mask = 0;
+            for (size_t f = 0; f < fields.size(); ++f)
+            {
+                if (fields[f].validity->get(i))
+                    mask |= 1u << f;
+            }
+
+            auto it = by_mask.find(mask);
+            if (it == by_mask.end())
+                it = by_mask.emplace(mask, prepared(insert_cql(layout, fields, mask))).first;
+
+            CassStatement *statement = cass_prepared_bind(it->second);
+            cass_statement_bind_int32_by_name(statement, columns.mcc, batch.mcc[i]);
+            cass_statement_bind_int32_by_name(statement, columns.mnc, batch.mnc[i]);
+            cass_statement_bind_int32_by_name(statement, columns.lac, batch.lac[i]);
+            cass_statement_bind_int64_by_name(statement, columns.cellid, batch.cellid[i]);
+            cass_statement_bind_int64_by_name(statement, columns.measured_at, batch.measured_at[i]);
+            bind_bucket(statement, batch.lac[i], batch.measured_at[i]);
+            for (size_t f = 0; f < fields.size(); ++f)
+            {
+                if (mask & (1u << f))
+                    fields[f].bind(statement, i);
+            }
+
+            // The future keeps what it needs; the statement can go right away
+            in_flight.push_back(cass_session_execute(db.get_session(), statement));
+            cass_statement_free(statement);
+
+            if (in_flight.size() >= max_in_flight)
+                finish_oldest();
+        }
+    }
+    catch (...)
+    {
+        while (!in_flight.empty())
+            finish_oldest();
+        throw;
+    }
+
+    while (!in_flight.empty())
+        finish_oldest();
+
+    if (!first_error.empty())
+        throw std::runtime_error("Batch insert failed: " + first_error);
+    if (rollups)
+        rollups->add(batch);
+}
+
+std::string measurement_manager::row_clause() const
+{
+    return layout.bucketed ? "mcc = ? AND mnc = ? AND lac_bucket = ? AND day = ? AND lac = ? AND cellid = ? AND measured_at = ?"
+                           : "mcc = ? AND mnc = ? AND lac = ? AND cellid = ? AND measured_at = ?";
+}
+
+void measurement_manager::bind_bucket(CassStatement *statement, int32_t lac, int64_t measured_at) const
+{
+    if (!layout.bucketed)
+        return;
+    cass_statement_bind_int32_by_name(statement, columns.lac_bucket, layout.lac_bucket(lac));
+    cass_statement_bind_int64_by_name(statement, columns.day, layout.day(measured_at));
+}
+
+void measurement_manager::record_buckets(const std::vector<bucket_id> &buckets)
+{
+    std::vector<bucket_id> fresh;
+    {
+        std::lock_guard<std::mutex> guard(bucket_lock);
+        for (const auto &bucket : buckets)
+        {
+            if (known_buckets.insert(bucket).second)
+                fresh.push_back(bucket);
+        }
+    }
+    if (fresh.empty())
+        return;
+
+    // Written before the rows, so a reader never misses a bucket that holds data
+    const CassPrepared *insert = prepared("INSERT INTO measurement_buckets (mcc, mnc, lac_bucket, day) VALUES (?, ?, ?, ?)");
+    std::vector<CassFuture *> futures;
+    futures.reserve(fresh.size());
+    for (const auto &bucket : fresh)
+    {
+        CassStatement *statement = cass_prepared_bind(insert);
+        cass_statement_bind_int32_by_name(statement, columns.mcc, std::get<0>(bucket));
+        cass_statement_bind_int32_by_name(statement, columns.mnc, std::get<1>(bucket));
+        cass_statement_bind_int32_by_name(statement, columns.lac_bucket, std::get<2>(bucket));
+        cass_statement_bind_int64_by_name(statement, columns.day, std::get<3>(bucket));
+        futures.push_back(cass_session_execute(db.get_session(), statement));
+        cass_statement_free(statement);
+    }
+
+    std::string first_error;
+    for (size_t i = 0; i < futures.size(); ++i)
+    {
+        cass_future_wait(futures[i]);
+        if (cass_future_error_code(futures[i]) != CASS_OK)
+        {
+            if (first_error.empty())
+                first_error = future_error(futures[i]);
+            // Retried by the next insert into this bucket
+            std::lock_guard<std::mutex> guard(bucket_lock);
+            known_buckets.erase(fresh[i]);
+        }
+        cass_future_free(futures[i]);
+    }
+    if (!first_error.empty())
+        throw std::runtime_error("Error recording measurement buckets: " + first_error);
+}
+
+namespace
+{
+    // Runs the statement over all of its pages, calling 'visit' for every row
+    void for_each_row(CassSession *session, CassStatement *statement, const std::function<void(const CassRow *)> &visit)
+    {
+        bool more_pages = true;
+        while (more_pages)
+        {
+            CassFuture *future = cass_session_execute(session, statement);
+            cass_future_wait(future);
+            if (cass_future_error_code(future) != CASS_OK)
+            {
+                std::string error = future_error(future);
+                cass_future_free(future);
+                throw std::runtime_error("Error fetching measurement buckets: " + error);
+            }
+            const CassResult *result = cass_future_get_result(future);
+            CassIterator *iterator = cass_iterator_from_result(result);
+            while (cass_iterator_next(iterator))
+                visit(cass_iterator_get_row(iterator));
+            cass_iterator_free(iterator);
+            more_pages = cass_result_has_more_pages(result);
+            if (more_pages)
+                cass_statement_set_paging_state(statement, result);
             cass_result_free(result);
             cass_future_free(future);
-            cass_statement_free(statement);
-            
         }
-        cass_result_free(result);
     }
-    else
+}
+
+std::vector<std::pair<int32_t, int64_t>> measurement_manager::operator_buckets(int32_t mcc, int32_t mnc)
+{
+    statement_guard guard(cass_prepared_bind(prepared("SELECT lac_bucket, day FROM measurement_buckets WHERE mcc = ? AND mnc = ?")));
+    cass_statement_bind_int32_by_name(guard.statement, columns.mcc, mcc);
+    cass_statement_bind_int32_by_name(guard.statement, columns.mnc, mnc);
+
+    std::vector<std::pair<int32_t, int64_t>> buckets;
+    for_each_row(db.get_session(), guard.statement, [&buckets](const CassRow *row) {
+        std::pair<int32_t, int64_t> bucket(0, 0);
+        get_value(cass_row_get_column_by_name(row, columns.lac_bucket), &bucket.first);
+        get_value(cass_row_get_column_by_name(row, columns.day), &bucket.second);
+        buckets.push_back(bucket);
+    });
+    return buckets;
+}
+
+measurement_batch measurement_manager::get_measurement_batch(int32_t mcc, int32_t mnc)
+{
+    trace_span span("measurement_manager::get_measurement_batch", "cassandra");
+    if (layout.bucketed)
     {
-        throw std::runtime_error("Error fetching tower location: " + std::string(cass_error_desc(cass_future_error_code(future))));
+        // Scatter to every bucket of the operator, gather in clustering order
+        const CassPrepared *select = prepared(
+            "SELECT * FROM measurements_by_bucket WHERE mcc = ? AND mnc = ? AND lac_bucket = ? AND day = ?");
+        std::vector<CassStatement *> statements;
+        for (const auto &bucket : operator_buckets(mcc, mnc))
+        {
+            CassStatement *statement = cass_prepared_bind(select);
+            cass_statement_bind_int32_by_name(statement, columns.mcc, mcc);
+            cass_statement_bind_int32_by_name(statement, columns.mnc, mnc);
+            cass_statement_bind_int32_by_name(statement, columns.lac_bucket, bucket.first);
+            cass_statement_bind_int64_by_name(statement, columns.day, bucket.second);
+            cass_statement_set_paging_size(statement, 5000);
+            statements.push_back(statement);
+        }
+        return merge_ordered(read_partitions(db.get_session(), statements, max_reads_in_flight));
     }
-    cass_future_free(future);
-    cass_statement_free(statement);
-    return c;
+
+    statement_guard guard(cass_prepared_bind(prepared("SELECT * FROM measurements WHERE mcc = ? AND mnc = ?")));
+    cass_statement_bind_int32_by_name(guard.statement, columns.mcc, mcc);
+    cass_statement_bind_int32_by_name(guard.statement, columns.mnc, mnc);
+    cass_statement_set_paging_size(guard.statement, 5000);
+
+    measurement_batch batch;
+    while (fetch_page(db.get_session(), guard.statement, batch, nullptr))
+    {
+    }
+    return batch;
+}
+
+size_t measurement_manager::scan_measurements(int32_t mcc, int32_t mnc,
+                                              const std::function<void(const measurement_batch &)> &consume)
+{
+    trace_span span("measurement_manager::scan_measurements", "cassandra");
+    size_t rows = 0;
+    if (layout.bucketed)
+    {
+        const CassPrepared *select = prepared(
+            "SELECT * FROM measurements_by_bucket WHERE mcc = ? AND mnc = ? AND lac_bucket = ? AND day = ?");
+        auto buckets = operator_buckets(mcc, mnc);
+        // One window of buckets in memory at a time
+        for (size_t first = 0; first < buckets.size(); first += max_reads_in_flight)
+        {
+            std::vector<CassStatement *> statements;
+            for (size_t b = first; b < std::min(buckets.size(), first + max_reads_in_flight); ++b)
+            {
+                CassStatement *statement = cass_prepared_bind(select);
+                cass_statement_bind_int32_by_name(statement, columns.mcc, mcc);
+                cass_statement_bind_int32_by_name(statement, columns.mnc, mnc);
+                cass_statement_bind_int32_by_name(statement, columns.lac_bucket, buckets[b].first);
+                cass_statement_bind_int64_by_name(statement, columns.day, buckets[b].second);
+                cass_statement_set_paging_size(statement, 5000);
+                statements.push_back(statement);
+            }
+            stream_partitions(db.get_session(), statements, max_reads_in_flight, [&](const measurement_batch &page) {
+                rows += page.size();
+                consume(page);
+                return true;
+            });
+        }
+        return rows;
+    }
+
+    statement_guard guard(cass_prepared_bind(prepared("SELECT * FROM measurements WHERE mcc = ? AND mnc = ?")));
+    cass_statement_bind_int32_by_name(guard.statement, columns.mcc, mcc);
+    cass_statement_bind_int32_by_name(guard.statement, columns.mnc, mnc);
+    cass_statement_set_paging_size(guard.statement, 5000);
+
+    measurement_batch batch;
+    bool more_pages = true;
+    while (more_pages)
+    {
+        batch.clear();
+        more_pages = fetch_page(db.get_session(), guard.statement, batch, nullptr);
+        rows += batch.size();
+        consume(batch);
+    }
+    return rows;
+}
+
+namespace
+{
+    void check_range(const measurement_range &range)
+    {
+        if (range.start_ms >= range.end_ms)
+            throw std::invalid_argument("measurement_range: start_ms must be before end_ms");
+        if (range.page_size <= 0)
+            throw std::invalid_argument("measurement_range: page_size must be positive");
+        if (range.limit < 0)
+            throw std::invalid_argument("measurement_range: limit must not be negative");
+    }
+}
+
+CassStatement *measurement_manager::range_statement(const measurement_range &range, int64_t day, int32_t limit,
+                                                    const std::string &paging_token)
+{
+    CassStatement *statement = cass_prepared_bind(prepared(range_cql(layout, range)));
+    cass_statement_bind_int32_by_name(statement, columns.mcc, range.mcc);
+    cass_statement_bind_int32_by_name(statement, columns.mnc, range.mnc);
+    cass_statement_bind_int32_by_name(statement, columns.lac, range.lac);
+    cass_statement_bind_int64_by_name(statement, columns.cellid, range.cellid);
+    // Both bounds bind to measured_at, so bind them (and the limit) by position
+    size_t bound = 4;
+    if (layout.bucketed)
+    {
+        cass_statement_bind_int32_by_name(statement, columns.lac_bucket, layout.lac_bucket(range.lac));
+        cass_statement_bind_int64_by_name(statement, columns.day, day);
+        bound = 6;
+    }
+    cass_statement_bind_int64(statement, bound, range.start_ms);
+    cass_statement_bind_int64(statement, bound + 1, range.end_ms);
+    if (range.limit > 0)
+        cass_statement_bind_int32(statement, bound + 2, limit);
+    cass_statement_set_paging_size(statement, range.page_size);
+    if (!paging_token.empty())
+        cass_statement_set_paging_state_token(statement, paging_token.data(), paging_token.size());
+    return statement;
+}
+
+std::vector<int64_t> measurement_manager::range_days(const measurement_range &range, const int64_t *from_day)
+{
+    statement_guard guard(cass_prepared_bind(prepared(
+        "SELECT day FROM measurement_buckets WHERE mcc = ? AND mnc = ? AND lac_bucket = ? AND day >= ? AND day <= ?")));
+    cass_statement_bind_int32_by_name(guard.statement, columns.mcc, range.mcc);
+    cass_statement_bind_int32_by_name(guard.statement, columns.mnc, range.mnc);
+    cass_statement_bind_int32_by_name(guard.statement, columns.lac_bucket, layout.lac_bucket(range.lac));
+    cass_statement_bind_int64(guard.statement, 3, layout.day(range.start_ms));
+    cass_statement_bind_int64(guard.statement, 4, layout.day(range.end_ms - 1));
+
+    std::vector<int64_t> days;
+    for_each_row(db.get_session(), guard.statement, [&days](const CassRow *row) {
+        int64_t day = 0;
+        get_value(cass_row_get_column_by_name(row, columns.day), &day);
+        days.push_back(day);
+    });
+    if (range.descending)
+        std::reverse(days.begin(), days.end());
+    if (from_day)
+    {
+        // Drop the days already read
+        auto done = [&range, from_day](int64_t day) { return range.descending ? day > *from_day : day < *from_day; };
+        days.erase(days.begin(), std::find_if_not(days.begin(), days.end(), done));
+    }
+    return days;
+}
+
+measurement_page measurement_manager::get_measurement_range(const measurement_range &range)
+{
+    trace_span span("measurement_manager::get_measurement_range", "cassandra");
+    check_range(range);
+    if (layout.bucketed)
+        return get_bucketed_range(range);
+
+    statement_guard guard(range_statement(range, 0, range.limit, range.paging_state));
+    measurement_page page;
+    fetch_page(db.get_session(), guard.statement, page.rows, &page.paging_state);
+    return page;
+}
+
+size_t measurement_manager::scan_measurement_range(const measurement_range &range,
+                                                   const std::function<void(const measurement_batch &)> &consume)
+{
+    trace_span span("measurement_manager::scan_measurement_range", "cassandra");
+    check_range(range);
+    if (layout.bucketed)
+        return scan_bucketed_range(range, consume);
+
+    statement_guard guard(range_statement(range, 0, range.limit, range.paging_state));
+
+    // One batch per page, reused so its buffers are allocated once
+    measurement_batch batch;
+    size_t rows = 0;
+    bool more_pages = true;
+    while (more_pages)
+    {
+        batch.clear();
+        more_pages = fetch_page(db.get_session(), guard.statement, batch, nullptr);
+        rows += batch.size();
+        consume(batch);
+    }
+    return rows;
+}
+
+measurement_page measurement_manager::get_bucketed_range(const measurement_range &range)
+{
+    bucket_cursor cursor;
+    bool resuming = !range.paging_state.empty();
+    if (resuming)
+        cursor = decode_cursor(range.paging_state);
+    std::vector<int64_t> days = range_days(range, resuming ? &cursor.day : nullptr);
+
+    // Day by day, one round trip each, until the page is full
+    measurement_page page;
+    int64_t returned = cursor.returned;
+    for (size_t d = 0; d < days.size(); ++d)
+    {
+        if (range.limit > 0 && returned >= range.limit)
+            break;
+        if (page.rows.size() >= (size_t)range.page_size)
+        {
+            bucket_cursor next;
+            next.day = days[d];
+            next.returned = returned;
+            page.paging_state = encode_cursor(next);
+            break;
+        }
+
+        bool same_day = resuming && days[d] == cursor.day;
+        statement_guard guard(range_statement(range, days[d], (int32_t)(range.limit - returned),
+                                              same_day ? cursor.token : std::string()));
+        cass_statement_set_paging_size(guard.statement, range.page_size - (int)page.rows.size());
+        size_t before = page.rows.size();
+        std::string token;
+        fetch_page(db.get_session(), guard.statement, page.rows, &token);
+        returned += page.rows.size() - before;
+        if (!token.empty())
+        {
+            bucket_cursor next;
+            next.day = days[d];
+            next.returned = returned;
+            next.token = token;
+            page.paging_state = encode_cursor(next);
+            break;
+        }
+    }
+    return page;
+}
+
+size_t measurement_manager::scan_bucketed_range(const measurement_range &range,
+                                                const std::function<void(const measurement_batch &)> &consume)
+{
+    bucket_cursor cursor;
+    bool resuming = !range.paging_state.empty();
+    if (resuming)
+        cursor = decode_cursor(range.paging_state);
+    std::vector<int64_t> days = range_days(range, resuming ? &cursor.day : nullptr);
+
+    // Days are read a window at a time, concurrently, and delivered in range order. Every
+    // read of a window is limited to what was left at its start; the excess is cut here.
+    size_t rows = 0;
+    int64_t returned = cursor.returned;
+    for (size_t first = 0; first < days.size(); first += max_reads_in_flight)
+    {
+        if (range.limit > 0 && returned >= range.limit)
+            break;
+        std::vector<CassStatement *> statements;
+        for (size_t d = first; d < std::min(days.size(), first + max_reads_in_flight); ++d)
+        {
+            bool same_day = resuming && days[d] == cursor.day;
+            statements.push_back(range_statement(range, days[d], (int32_t)(range.limit - returned),
+                                                 same_day ? cursor.token : std::string()));
+        }
+        stream_partitions(db.get_session(), statements, max_reads_in_flight, [&](const measurement_batch &page) {
+            if (range.limit > 0 && returned >= range.limit)
+                return false;
+            if (range.limit > 0 && returned + (int64_t)page.size() > range.limit)
+            {
+                measurement_batch rest = head(page, range.limit - returned);
+                returned += rest.size();
+                rows += rest.size();
+                consume(rest);
+                return false;
+            }
+            returned += page.size();
+            rows += page.size();
+            consume(page);
+            return true;
+        });
+    }
+    return rows;
+}
+
+namespace
+{
+    // Executes statement 'bind(i)' for every i < n with at most 'concurrency' in flight and
+    // passes each result to 'read(i, result)'. Results carry their index, so callers can
+    // store them in input order whatever order they complete in.
+    void execute_all(CassSession *session, size_t n, size_t concurrency,
+                     const std::function<CassStatement *(size_t)> &bind,
+                     const std::function<void(size_t, const CassResult *)> &read)
+    {
+        if (concurrency == 0)
+            throw std::invalid_argument("concurrency must be positive");
+
+        std::deque<std::pair<size_t, CassFuture *>> in_flight;
+        std::string first_error;
+
+        auto finish_oldest = [&]() {
+            auto entry = in_flight.front();
+            in_flight.pop_front();
+            cass_future_wait(entry.second);
+            if (cass_future_error_code(entry.second) != CASS_OK)
+            {
+                if (first_error.empty())
+                    first_error = future_error(entry.second);
+            }
+            else if (first_error.empty())
+            {
+                const CassResult *result = cass_future_get_result(entry.second);
+                read(entry.first, result);
+                cass_result_free(result);
+            }
+            cass_future_free(entry.second);
+        };
+
+        try
+        {
+            for (size_t i = 0; i < n && first_error.empty(); ++i)
+            {
+                CassStatement *statement = bind(i);
+                in_flight.emplace_back(i, cass_session_execute(session, statement));
+                cass_statement_free(statement);
+                if (in_flight.size() >= concurrency)
+                    finish_oldest();
+            }
+        }
+        catch (...)
+        {
+            while (!in_flight.empty())
+                finish_oldest();
+            throw;
+        }
+
+        while (!in_flight.empty())
+            finish_oldest();
+        if (!first_error.empty())
+            throw std::runtime_error("Error fetching measurements: " + first_error);
+    }
+}
+
+std::vector<measurement> measurement_manager::get_measurements(const std::vector<keys> &lookups, size_t concurrency)
+{
+    trace_span span("measurement_manager::get_measurements_by_key", "cassandra");
+    const CassPrepared *select = prepared("SELECT * FROM " + std::string(layout.table()) + " WHERE " + row_clause());
+
+    // Rows are decoded into one batch as they arrive; slot[i] is the row of lookup i
+    measurement_batch rows;
+    std::vector<size_t> slot(lookups.size(), SIZE_MAX);
+    execute_all(
+        db.get_session(), lookups.size(), concurrency,
+        [&](size_t i) {
+            const keys &k = lookups[i];
+            CassStatement *statement = cass_prepared_bind(select);
+            cass_statement_bind_int32_by_name(statement, columns.mcc, k.mcc);
+            cass_statement_bind_int32_by_name(statement, columns.mnc, k.mnc);
+            cass_statement_bind_int32_by_name(statement, columns.lac, k.lac);
+            cass_statement_bind_int64_by_name(statement, columns.cellid, k.cellid);
+            cass_statement_bind_int64_by_name(statement, columns.measured_at, k.measured_at);
+            bind_bucket(statement, k.lac, k.measured_at);
+            return statement;
+        },
+        [&](size_t i, const CassResult *result) {
+            if (cass_result_row_count(result) == 0)
+                return;
+            slot[i] = rows.size();
+            read_row(cass_result_first_row(result), rows);
+        });
+
+    std::vector<measurement> results(lookups.size());
+    for (size_t i = 0; i < lookups.size(); ++i)
+    {
+        if (slot[i] != SIZE_MAX)
+            results[i] = rows.row(slot[i]);
+    }
+    return results;
+}
+
+std::vector<core> measurement_manager::get_tower_locations(const std::vector<keys> &cells, size_t concurrency)
+{
+    trace_span span("measurement_manager::get_tower_locations", "cassandra");
+    std::vector<core> results(cells.size());
+    auto read_core = [](const CassRow *row, core &c) {
+        get_value(cass_row_get_column_by_name(row, columns.lat), &c.lat);
+        get_value(cass_row_get_column_by_name(row, columns.lon), &c.lon);
+        get_value(cass_row_get_column_by_name(row, columns.rating), &c.rating);
+        get_value(cass_row_get_column_by_name(row, columns.range), &c.range);
+    };
+
+    if (layout.bucketed)
+    {
+        // 1. Days of every distinct (mcc, mnc, lac_bucket), concurrently
+        std::map<std::tuple<int32_t, int32_t, int32_t>, std::vector<int64_t>> days;
+        for (size_t i = 0; i < cells.size(); ++i)
+            days.emplace(std::make_tuple(cells[i].mcc, cells[i].mnc, layout.lac_bucket(cells[i].lac)), std::vector<int64_t>());
+        std::vector<std::pair<const std::tuple<int32_t, int32_t, int32_t>, std::vector<int64_t>> *> groups;
+        for (auto &entry : days)
+            groups.push_back(&entry);
+
+        const CassPrepared *list_days =
+            prepared("SELECT day FROM measurement_buckets WHERE mcc = ? AND mnc = ? AND lac_bucket = ?");
+        execute_all(
+            db.get_session(), groups.size(), concurrency,
+            [&](size_t g) {
+                const auto &group = groups[g]->first;
+                CassStatement *statement = cass_prepared_bind(list_days);
+                cass_statement_bind_int32_by_name(statement, columns.mcc, std::get<0>(group));
+                cass_statement_bind_int32_by_name(statement, columns.mnc, std::get<1>(group));
+                cass_statement_bind_int32_by_name(statement, columns.lac_bucket, std::get<2>(group));
+                // A few rows per day at most; one response
+                cass_statement_set_paging_size(statement, -1);
+                return statement;
+            },
+            [&](size_t g, const CassResult *result) {
+                CassIterator *iterator = cass_iterator_from_result(result);
+                while (cass_iterator_next(iterator))
+                {
+                    int64_t day = 0;
+                    get_value(cass_row_get_column_by_name(cass_iterator_get_row(iterator), columns.day), &day);
+                    groups[g]->second.push_back(day);
+                }
+                cass_iterator_free(iterator);
+            });
+
+        for (auto &entry : days)
+            std::sort(entry.second.begin(), entry.second.end());
+
+        // 2. The first row of each day partition, of which the earliest day wins, as LIMIT 1
+        //    does on the single operator partition. Days are read oldest first, at most
+        //    days_per_query per query, and a cell stops at the first chunk holding it.
+        const size_t days_per_query = 8;
+        const CassPrepared *select = prepared(
+            "SELECT day, lat, lon, rating, range FROM measurements_by_bucket WHERE mcc = ? AND mnc = ? "
+            "AND lac_bucket = ? AND day IN ? AND lac = ? AND cellid = ? PER PARTITION LIMIT 1");
+        std::vector<size_t> pending;
+        for (size_t i = 0; i < cells.size(); ++i)
+        {
+            if (!days[std::make_tuple(cells[i].mcc, cells[i].mnc, layout.lac_bucket(cells[i].lac))].empty())
+                pending.push_back(i);
+        }
+        for (size_t first = 0; !pending.empty(); first += days_per_query)
+        {
+            std::vector<char> found(pending.size(), 0);
+            execute_all(
+                db.get_session(), pending.size(), concurrency,
+                [&](size_t p) {
+                    const keys &k = cells[pending[p]];
+                    const auto &cell_days = days[std::make_tuple(k.mcc, k.mnc, layout.lac_bucket(k.lac))];
+                    const size_t last = std::min(cell_days.size(), first + days_per_query);
+                    CassCollection *day_list = cass_collection_new(CASS_COLLECTION_TYPE_LIST, last - first);
+                    for (size_t j = first; j < last; ++j)
+                        cass_collection_append_int64(day_list, cell_days[j]);
+
+                    CassStatement *statement = cass_prepared_bind(select);
+                    cass_statement_bind_int32(statement, 0, k.mcc);
+                    cass_statement_bind_int32(statement, 1, k.mnc);
+                    cass_statement_bind_int32(statement, 2, layout.lac_bucket(k.lac));
+                    cass_statement_bind_collection(statement, 3, day_list);
+                    cass_statement_bind_int32(statement, 4, k.lac);
+                    cass_statement_bind_int64(statement, 5, k.cellid);
+                    cass_statement_set_paging_size(statement, -1);
+                    cass_collection_free(day_list);
+                    return statement;
+                },
+                [&](size_t p, const CassResult *result) {
+                    int64_t first_day = std::numeric_limits<int64_t>::max();
+                    CassIterator *iterator = cass_iterator_from_result(result);
+                    while (cass_iterator_next(iterator))
+                    {
+                        const CassRow *row = cass_iterator_get_row(iterator);
+                        int64_t day = 0;
+                        get_value(cass_row_get_column_by_name(row, columns.day), &day);
+                        if (day < first_day)
+                        {
+                            first_day = day;
+                            results[pending[p]] = core();
+                            read_core(row, results[pending[p]]);
+                        }
+                    }
+                    cass_iterator_free(iterator);
+                    found[p] = first_day != std::numeric_limits<int64_t>::max();
+                });
+
+            // Cells not found yet move on to their next chunk of days, if any is left
+            std::vector<size_t> next;
+            for (size_t p = 0; p < pending.size(); ++p)
+            {
+                const keys &k = cells[pending[p]];
+                if (!found[p] && first + days_per_query <
+                                     days[std::make_tuple(k.mcc, k.mnc, layout.lac_bucket(k.lac))].size())
+                    next.push_back(pending[p]);
+            }
+            pending.swap(next);
+        }
+        return results;
+    }
+
+    const CassPrepared *select = prepared(
+        "SELECT lat, lon, rating, range FROM measurements WHERE mcc = ? AND mnc = ? AND lac = ? AND cellid = ? LIMIT 1");
+    execute_all(
+        db.get_session(), cells.size(), concurrency,
+        [&](size_t i) {
+            const keys &k = cells[i];
+            CassStatement *statement = cass_prepared_bind(select);
+            cass_statement_bind_int32_by_name(statement, columns.mcc, k.mcc);
+            cass_statement_bind_int32_by_name(statement, columns.mnc, k.mnc);
+            cass_statement_bind_int32_by_name(statement, columns.lac, k.lac);
+            cass_statement_bind_int64_by_name(statement, columns.cellid, k.cellid);
+            return statement;
+        },
+        [&](size_t i, const CassResult *result) {
+            if (cass_result_row_count(result) > 0)
+                read_core(cass_result_first_row(result), results[i]);
+        });
+    return results;
+}
+
+size_t measurement_manager::update_signals(const std::vector<signal_update> &updates, std::vector<signal_update> *failed)
+{
+    trace_span span("measurement_manager::update_signals", "cassandra");
+    if (updates.empty())
+        return 0;
+
+    // Partition of each update under the current layout; sorting groups them
+    auto partition_of = [this](const keys &k) {
+        return layout.bucketed ? std::make_tuple(k.mcc, k.mnc, layout.lac_bucket(k.lac), layout.day(k.measured_at))
+                               : std::make_tuple(k.mcc, k.mnc, 0, (int64_t)0);
+    };
+    std::vector<size_t> order(updates.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return partition_of(updates[a].key) < partition_of(updates[b].key);
+    });
+
+    const CassPrepared *update;
+    try
+    {
+        update = prepared("UPDATE " + std::string(layout.table()) + " SET signal = ? WHERE " + row_clause());
+    }
+    catch (...)
+    {
+        if (failed)
+            failed->insert(failed->end(), updates.begin(), updates.end());
+        throw;
+    }
+
+    // Each in-flight batch covers order[first, last)
+    struct sent_batch {
+        CassFuture *future;
+        size_t first, last;
+    };
+    std::deque<sent_batch> in_flight;
+    std::string first_error;
+    size_t batches = 0;
+
+    auto finish_oldest = [&]() {
+        sent_batch oldest = in_flight.front();
+        in_flight.pop_front();
+        cass_future_wait(oldest.future);
+        if (cass_future_error_code(oldest.future) != CASS_OK)
+        {
+            if (first_error.empty())
+                first_error = future_error(oldest.future);
+            if (failed)
+            {
+                for (size_t j = oldest.first; j < oldest.last; ++j)
+                    failed->push_back(updates[order[j]]);
+            }
+        }
+        cass_future_free(oldest.future);
+    };
+
+    size_t first = 0;
+    while (first < order.size())
+    {
+        // One partition, at most max_batch_rows statements
+        size_t last = first + 1;
+        auto partition = partition_of(updates[order[first]].key);
+        while (last < order.size() && last - first < max_batch_rows && partition_of(updates[order[last]].key) == partition)
+            ++last;
+
+        CassBatch *batch = cass_batch_new(CASS_BATCH_TYPE_UNLOGGED);
+        for (size_t j = first; j < last; ++j)
+        {
+            const signal_update &u = updates[order[j]];
+            CassStatement *statement = cass_prepared_bind(update);
+            cass_statement_bind_int32_by_name(statement, columns.signal, u.signal);
+            cass_statement_bind_int32_by_name(statement, columns.mcc, u.key.mcc);
+            cass_statement_bind_int32_by_name(statement, columns.mnc, u.key.mnc);
+            cass_statement_bind_int32_by_name(statement, columns.lac, u.key.lac);
+            cass_statement_bind_int64_by_name(statement, columns.cellid, u.key.cellid);
+            cass_statement_bind_int64_by_name(statement, columns.measured_at, u.key.measured_at);
+            bind_bucket(statement, u.key.lac, u.key.measured_at);
+            cass_batch_add_statement(batch, statement);
+            cass_statement_free(statement);
+        }
+        in_flight.push_back({cass_session_execute_batch(db.get_session(), batch), first, last});
+        cass_batch_free(batch);
+        ++batches;
+        first = last;
+
+        if (in_flight.size() >= max_in_flight)
+            finish_oldest();
+    }
+    while (!in_flight.empty())
+        finish_oldest();
+
+    if (!first_error.empty())
+        throw std::runtime_error("Signal update failed: " + first_error);
+    return batches;
 }
 
 void json_helper::to_json(json &j, const keys &k)
@@ -0,0 +1,228 @@
+#include "db/access/measurement_batch.hpp"
+
+namespace
+{
+    const std::string empty_string;
+
+    // Zero stands for "absent" in measurement
+    template <typename T>
+    void push_nonzero(column<T> &c, T value)
+    {
+        if (value != 0)
+            c.push_back(value);
+        else
+            c.push_null();
+    }
+
+    void push_nonempty(dictionary_column &c, const std::string &value)
+    {
+        if (!value.empty())
+            c.push_back(value);
+        else
+            c.push_null();
+    }
+
+    template <typename T>
+    void push_from(column<T> &c, const column<T> &from, size_t i)
+    {
+        if (from.valid(i))
+            c.push_back(from.values[i]);
+        else
+            c.push_null();
+    }
+
+    // Strings are re-encoded, since the two batches have their own dictionaries
+    void push_from(dictionary_column &c, const dictionary_column &from, size_t i)
+    {
+        if (from.valid(i))
+            c.push_back(from.at(i));
+        else
+            c.push_null();
+    }
+
+    template <typename... Columns>
+    void reserve_all(size_t rows, Columns &...columns)
+    {
+        (columns.reserve(rows), ...);
+    }
+
+    template <typename... Columns>
+    void clear_all(Columns &...columns)
+    {
+        (columns.clear(), ...);
+    }
+}
+
+size_t validity_bitmap::count() const
+{
+    size_t total = 0;
+    for (uint64_t w : words)
+        total += __builtin_popcountll(w);
+    return total;
+}
+
+int32_t string_dictionary::encode(const std::string &value)
+{
+    auto it = index.find(value);
+    if (it != index.end())
+        return it->second;
+
+    int32_t code = (int32_t)values.size();
+    values.push_back(value);
+    index.emplace(value, code);
+    return code;
+}
+
+int32_t string_dictionary::find(const std::string &value) const
+{
+    auto it = index.find(value);
+    return it != index.end() ? it->second : -1;
+}
+
+const std::string &dictionary_column::at(size_t i) const
+{
+    return codes.valid(i) ? dictionary.decode(codes.values[i]) : empty_string;
+}
+
+void measurement_batch::reserve(size_t rows)
+{
+    reserve_all(rows, mcc, mnc, lac, cellid, measured_at, lat, lon, rating, range, radio.codes, apikey.codes,
+                devn.codes, unit, samples, changeable, avg_signal, created_at, updated_at, signal, speed,
+                direction, ta, tac, pci, sid, nid, bid);
+}
+
+void measurement_batch::clear()
+{
+    clear_all(mcc, mnc, lac, cellid, measured_at, lat, lon, rating, range, radio.codes, apikey.codes, devn.codes,
+              radio.dictionary, apikey.dictionary, devn.dictionary, unit, samples, changeable, avg_signal,
+              created_at, updated_at, signal, speed, direction, ta, tac, pci, sid, nid, bid);
+}
+
+void measurement_batch::append(const measurement &m)
+{
+    mcc.push_back(m.key.mcc);
+    mnc.push_back(m.key.mnc);
+    lac.push_back(m.key.lac);
+    cellid.push_back(m.key.cellid);
+    measured_at.push_back(m.key.measured_at);
+
+    push_nonzero(lat, m.core_data.lat);
+    push_nonzero(lon, m.core_data.lon);
+    push_nonzero(rating, m.core_data.rating);
+    push_nonzero(range, m.core_data.range);
+
+    push_nonempty(radio, m.radio);
+    push_nonempty(apikey, m.apikey);
+    push_nonempty(devn, m.devn);
+
+    push_nonzero(unit, m.stats_data.unit);
+    push_nonzero(samples, m.stats_data.samples);
+    push_nonzero(changeable, m.stats_data.changeable);
+    push_nonzero(avg_signal, m.stats_data.avg_signal);
+    push_nonzero(created_at, m.stats_data.created_at);
+    push_nonzero(updated_at, m.stats_data.updated_at);
+
+    push_nonzero(signal, m.movement_data.signal);
+    push_nonzero(speed, m.movement_data.speed);
+    push_nonzero(direction, m.movement_data.direction);
+
+    push_nonzero(ta, m.tech.ta);
+    push_nonzero(tac, m.tech.tac);
+    push_nonzero(pci, m.tech.pci);
+    push_nonzero(sid, m.tech.sid);
+    push_nonzero(nid, m.tech.nid);
+    push_nonzero(bid, m.tech.bid);
+}
+
+void measurement_batch::append(const measurement_batch &other, size_t i)
+{
+    mcc.push_back(other.mcc[i]);
+    mnc.push_back(other.mnc[i]);
+    lac.push_back(other.lac[i]);
+    cellid.push_back(other.cellid[i]);
+    measured_at.push_back(other.measured_at[i]);
+
+    push_from(lat, other.lat, i);
+    push_from(lon, other.lon, i);
+    push_from(rating, other.rating, i);
+    push_from(range, other.range, i);
+
+    push_from(radio, other.radio, i);
+    push_from(apikey, other.apikey, i);
+    push_from(devn, other.devn, i);
+
+    push_from(unit, other.unit, i);
+    push_from(samples, other.samples, i);
+    push_from(changeable, other.changeable, i);
+    push_from(avg_signal, other.avg_signal, i);
+    push_from(created_at, other.created_at, i);
+    push_from(updated_at, other.updated_at, i);
+
+    push_from(signal, other.signal, i);
+    push_from(speed, other.speed, i);
+    push_from(direction, other.direction, i);
+
+    push_from(ta, other.ta, i);
+    push_from(tac, other.tac, i);
+    push_from(pci, other.pci, i);
+    push_from(sid, other.sid, i);
+    push_from(nid, other.nid, i);
+    push_from(bid, other.bid, i);
+}
+
+measurement measurement_batch::row(size_t i) const
+{
+    // Invalid slots hold T(), so the values can be copied without checking validity
+    measurement m;
+    m.key.mcc = mcc[i];
+    m.key.mnc = mnc[i];
+    m.key.lac = lac[i];
+    m.key.cellid = cellid[i];
+    m.key.measured_at = measured_at[i];
+
+    m.core_data.lat = lat.values[i];
+    m.core_data.lon = lon.values[i];
+    m.core_data.rating = rating.values[i];
+    m.core_data.range = range.values[i];
+
+    m.radio = radio.at(i);
+    m.apikey = apikey.at(i);
+    m.devn = devn.at(i);
+
+    m.stats_data.unit = unit.values[i];
+    m.stats_data.samples = samples.values[i];
+    m.stats_data.changeable = changeable.values[i];
+    m.stats_data.avg_signal = avg_signal.values[i];
+    m.stats_data.created_at = created_at.values[i];
+    m.stats_data.updated_at = updated_at.values[i];
+
+    m.movement_data.signal = signal.values[i];
+    m.movement_data.speed = speed.values[i];
+    m.movement_data.direction = direction.values[i];
+
+    m.tech.ta = ta.values[i];
+    m.tech.tac = tac.values[i];
+    m.tech.pci = pci.values[i];
+    m.tech.sid = sid.values[i];
+    m.tech.nid = nid.values[i];
+    m.tech.bid = bid.values[i];
+    return m;
+}
+
+measurement_batch measurement_batch::from_rows(const std::vector<measurement> &rows)
+{
+    measurement_batch batch;
+    batch.reserve(rows.size());
+    for (const auto &m : rows)
+        batch.append(m);
+    return batch;
+}
+
+std::vector<measurement> measurement_batch::to_rows() const
+{
+    std::vector<measurement> rows;
+    rows.reserve(size());
+    for (size_t i = 0; i < size(); ++i)
+        rows.push_back(row(i));
+    return rows;
+}
@@ -0,0 +1,170 @@
+#include "db/access/signal_update_buffer.hpp"
+#include "internal/hash.hpp"
+#include "trace/trace.hpp"
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+using internal::mix;
+
+size_t signal_update_buffer::key_hash::operator()(const keys &k) const
+{
+    uint64_t h = mix(((uint64_t)(uint32_t)k.mcc << 32) | (uint32_t)k.mnc);
+    h = mix(h ^ (uint32_t)k.lac);
+    h = mix(h ^ (uint64_t)k.cellid);
+    return (size_t)mix(h ^ (uint64_t)k.measured_at);
+}
+
+signal_update_buffer::signal_update_buffer(measurement_manager &manager, signal_buffer_options options)
+    : manager(manager), options(options), stopping(false), updates(0), writes(0), flushes(0), failed_flushes(0),
+      flusher(&signal_update_buffer::run, this)
+{
+}
+
+signal_update_buffer::~signal_update_buffer()
+{
+    try
+    {
+        shutdown();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error: signal_update_buffer final flush: " << e.what() << std::endl;
+    }
+}
+
+void signal_update_buffer::update(int32_t mcc, int32_t mnc, int32_t lac, int64_t cellid, int64_t ts,
+                                  int32_t new_signal)
+{
+    keys k;
+    k.mcc = mcc;
+    k.mnc = mnc;
+    k.lac = lac;
+    k.cellid = cellid;
+    k.measured_at = ts;
+
+    bool full;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (stopping)
+            throw std::runtime_error("signal_update_buffer: update after shutdown");
+        if (pending.empty())
+        {
+            // Starts the delay timer of the background thread
+            oldest = std::chrono::steady_clock::now();
+            wake.notify_one();
+        }
+        pending[k] = new_signal;
+        full = pending.size() >= options.max_pending;
+    }
+    ++updates;
+    if (full)
+        flush();
+}
+
+size_t signal_update_buffer::flush()
+{
+    trace_span span("signal_update_buffer::flush", "cassandra");
+    std::lock_guard<std::mutex> serial(flush_lock);
+
+    // Updates carry on into an empty map while this one is written
+    update_map taken;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        taken.swap(pending);
+    }
+    if (taken.empty())
+        return 0;
+
+    std::vector<signal_update> rows;
+    rows.reserve(taken.size());
+    for (const auto &entry : taken)
+    {
+        signal_update u;
+        u.key = entry.first;
+        u.signal = entry.second;
+        rows.push_back(u);
+    }
+
+    std::vector<signal_update> failed;
+    try
+    {
+        manager.update_signals(rows, &failed);
+    }
+    catch (...)
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            // emplace keeps a newer value that arrived during the flush
+            for (const auto &u : failed)
+                pending.emplace(u.key, u.signal);
+            // Retried after max_delay_ms rather than in a tight loop
+            oldest = std::chrono::steady_clock::now();
+        }
+        writes += rows.size() - failed.size();
+        ++flushes;
+        ++failed_flushes;
+        throw;
+    }
+    writes += rows.size();
+    ++flushes;
+    return rows.size();
+}
+
+void signal_update_buffer::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (flusher.joinable())
+        flusher.join();
+    flush();
+}
+
+void signal_update_buffer::run()
+{
+    std::unique_lock<std::mutex> guard(lock);
+    while (!stopping)
+    {
+        if (pending.empty())
+        {
+            wake.wait(guard);
+            continue;
+        }
+        auto due = oldest + std::chrono::milliseconds(options.max_delay_ms);
+        if (std::chrono::steady_clock::now() < due)
+        {
+            wake.wait_until(guard, due);
+            continue;
+        }
+
+        guard.unlock();
+        try
+        {
+            flush();
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Error: signal_update_buffer flush: " << e.what() << std::endl;
+        }
+        guard.lock();
+    }
+}
+
+size_t signal_update_buffer::pending_rows() const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return pending.size();
+}
+
+signal_buffer_stats signal_update_buffer::stats() const
+{
+    signal_buffer_stats s;
+    s.updates = updates.load();
+    s.writes = writes.load();
+    s.flushes = flushes.load();
+    s.failed_flushes = failed_flushes.load();
+    return s;
+}
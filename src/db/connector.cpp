@@ -1,15 +1,12 @@
 #include "db/connector.hpp"
+#include "internal/cass_helpers.hpp"
 
 void connector::check_future_error(CassFuture *future, const std::string &error_prefix)
 {
     cass_future_wait(future);
     CassError code = cass_future_error_code(future);
     if (code != CASS_OK) {
-        const char* message;
-        size_t message_length;
-        cass_future_error_message(future, &message, &message_length);
-        std::string err(message, message_length);
-        throw std::runtime_error(error_prefix + " | Reason: " + err);
+        throw std::runtime_error(error_prefix + " | Reason: " + internal::future_error(future));
     }    
 }
 
@@ -0,0 +1,117 @@
+// Backfills the bucketed measurement layout (db/schema.hpp) from the per-operator table.
+//
+// Each operator partition is streamed page by page and written with batch inserts, so a
+// large operator never has to fit in memory. Inserts are upserts: rerunning the tool
+// (for example after switching writers to the bucketed layout) only rewrites rows.
+
+#include <db/access/measurement.hpp>
+#include <db/access/measurement_batch.hpp>
+#include <db/connector.hpp>
+#include <db/schema.hpp>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    // Every (mcc, mnc) partition of the source table
+    std::vector<std::pair<int32_t, int32_t>> list_operators(connector &db)
+    {
+        std::vector<std::pair<int32_t, int32_t>> operators;
+        CassStatement *statement = cass_statement_new("SELECT DISTINCT mcc, mnc FROM measurements", 0);
+        cass_statement_set_paging_size(statement, 1000);
+        bool more_pages = true;
+        while (more_pages)
+        {
+            CassFuture *future = cass_session_execute(db.get_session(), statement);
+            cass_future_wait(future);
+            if (cass_future_error_code(future) != CASS_OK)
+            {
+                cass_future_free(future);
+                cass_statement_free(statement);
+                throw std::runtime_error("Error listing operators");
+            }
+            const CassResult *result = cass_future_get_result(future);
+            CassIterator *iterator = cass_iterator_from_result(result);
+            while (cass_iterator_next(iterator))
+            {
+                const CassRow *row = cass_iterator_get_row(iterator);
+                std::pair<int32_t, int32_t> op(0, 0);
+                cass_value_get_int32(cass_row_get_column_by_name(row, columns.mcc), &op.first);
+                cass_value_get_int32(cass_row_get_column_by_name(row, columns.mnc), &op.second);
+                operators.push_back(op);
+            }
+            cass_iterator_free(iterator);
+            more_pages = cass_result_has_more_pages(result);
+            if (more_pages)
+                cass_statement_set_paging_state(statement, result);
+            cass_result_free(result);
+            cass_future_free(future);
+        }
+        cass_statement_free(statement);
+        return operators;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <hosts> [--lac-buckets N] [--day-ms MS] [mcc:mnc ...]\n"
+                  << "Copies the given operators (default: all) into measurements_by_bucket.\n";
+        return 1;
+    }
+
+    schema_options options;
+    int32_t lac_buckets = options.layout.lac_buckets;
+    int64_t day_ms = options.layout.day_ms;
+    std::vector<std::pair<int32_t, int32_t>> operators;
+    for (int i = 2; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--lac-buckets" && i + 1 < argc)
+            lac_buckets = std::stoi(argv[++i]);
+        else if (arg == "--day-ms" && i + 1 < argc)
+            day_ms = std::stoll(argv[++i]);
+        else
+        {
+            size_t colon = arg.find(':');
+            if (colon == std::string::npos)
+            {
+                std::cerr << "Expected mcc:mnc, got " << arg << "\n";
+                return 1;
+            }
+            operators.emplace_back(std::stoi(arg.substr(0, colon)), std::stoi(arg.substr(colon + 1)));
+        }
+    }
+
+    try
+    {
+        connector db;
+        db.connect(argv[1]);
+        options.layout = measurement_layout::by_bucket(lac_buckets, day_ms);
+        schema::create(db, options);
+
+        measurement_manager source(db);
+        measurement_manager target(db, nullptr, options.layout);
+        if (operators.empty())
+            operators = list_operators(db);
+
+        size_t total = 0;
+        for (const auto &op : operators)
+        {
+            size_t rows = source.scan_measurements(op.first, op.second,
+                                                   [&target](const measurement_batch &page) { target.insert(page); });
+            std::cout << op.first << ":" << op.second << " " << rows << " rows" << std::endl;
+            total += rows;
+        }
+        std::cout << "Migrated " << total << " rows of " << operators.size() << " operators" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "ERROR: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
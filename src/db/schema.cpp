@@ -0,0 +1,85 @@
+#include "db/schema.hpp"
+#include <cctype>
+#include <stdexcept>
+
+namespace
+{
+    // Every non-key column of a measurement row
+    const char *const measurement_columns =
+        "lat double, lon double, rating double, range int, "
+        "apikey text, radio text, devn text, "
+        "unit int, samples int, changeable int, avg_signal int, created_at bigint, updated_at bigint, "
+        "signal int, speed double, direction double, "
+        "ta int, tac int, pci int, sid int, nid int, bid int";
+
+    // The keyspace name ends up in the CQL text
+    void check_identifier(const std::string &name)
+    {
+        bool valid = !name.empty() && std::isalpha((unsigned char)name[0]);
+        for (char c : name)
+            valid = valid && (std::isalnum((unsigned char)c) || c == '_');
+        if (!valid)
+            throw std::invalid_argument("Invalid keyspace name: " + name);
+    }
+}
+
+measurement_layout measurement_layout::by_bucket(int32_t lac_buckets, int64_t day_ms)
+{
+    if (lac_buckets <= 0 || day_ms <= 0)
+        throw std::invalid_argument("measurement_layout: lac_buckets and day_ms must be positive");
+    measurement_layout layout;
+    layout.bucketed = true;
+    layout.lac_buckets = lac_buckets;
+    layout.day_ms = day_ms;
+    return layout;
+}
+
+int32_t measurement_layout::lac_bucket(int32_t lac) const
+{
+    int32_t bucket = lac % lac_buckets;
+    return bucket < 0 ? bucket + lac_buckets : bucket;
+}
+
+int64_t measurement_layout::day(int64_t measured_at) const
+{
+    // Floor, so times before the epoch fall into the right day too
+    int64_t d = measured_at / day_ms;
+    return (measured_at % day_ms < 0) ? d - 1 : d;
+}
+
+void schema::create(connector &db, const schema_options &options)
+{
+    check_identifier(options.keyspace);
+    if (options.replication_factor <= 0)
+        throw std::invalid_argument("schema_options: replication_factor must be positive");
+    const std::string &ks = options.keyspace;
+
+    db.execute_query("CREATE KEYSPACE IF NOT EXISTS " + ks +
+                     " WITH replication = {'class': 'SimpleStrategy', 'replication_factor': " +
+                     std::to_string(options.replication_factor) + "}");
+
+    db.execute_query("CREATE TABLE IF NOT EXISTS " + ks + ".measurements ("
+                     "mcc int, mnc int, lac int, cellid bigint, measured_at bigint, " +
+                     std::string(measurement_columns) +
+                     ", PRIMARY KEY ((mcc, mnc), lac, cellid, measured_at))");
+
+    if (options.layout.bucketed)
+    {
+        db.execute_query("CREATE TABLE IF NOT EXISTS " + ks + ".measurements_by_bucket ("
+                         "mcc int, mnc int, lac_bucket int, day bigint, lac int, cellid bigint, measured_at bigint, " +
+                         std::string(measurement_columns) +
+                         ", PRIMARY KEY ((mcc, mnc, lac_bucket, day), lac, cellid, measured_at))");
+        db.execute_query("CREATE TABLE IF NOT EXISTS " + ks + ".measurement_buckets ("
+                         "mcc int, mnc int, lac_bucket int, day bigint, "
+                         "PRIMARY KEY ((mcc, mnc), lac_bucket, day))");
+    }
+
+    // Written by rollup_aggregator::flush (db/access/cell_rollup.hpp)
+    db.execute_query("CREATE TABLE IF NOT EXISTS " + ks + ".cell_rollups ("
+                     "mcc int, mnc int, lac int, cellid bigint, bucket_start bigint, flush_id bigint, "
+                     "samples bigint, signal_count bigint, signal_sum double, signal_min double, signal_max double, "
+                     "first_seen bigint, last_seen bigint, signal_sketch blob, "
+                     "PRIMARY KEY ((mcc, mnc, lac, cellid), bucket_start, flush_id))");
+
+    db.execute_query("USE " + ks);
+}
@@ -0,0 +1,181 @@
+#include "geo/spatial_index.hpp"
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace
+{
+    constexpr double earth_radius_m = 6371008.8;
+    constexpr double deg_to_rad = 3.14159265358979323846 / 180.0;
+    constexpr uint64_t missing_cell = std::numeric_limits<uint64_t>::max();
+
+    // Splits [0, n) into n_threads contiguous chunks and runs fn(begin, end) on each.
+    template <typename F>
+    void parallel_chunks(size_t n, unsigned n_threads, F &&fn)
+    {
+        std::vector<std::thread> pool;
+        size_t chunk = (n + n_threads - 1) / n_threads;
+        for (unsigned t = 0; t < n_threads; ++t)
+        {
+            size_t begin = std::min(n, t * chunk), end = std::min(n, begin + chunk);
+            if (begin < end)
+                pool.emplace_back(fn, begin, end);
+        }
+        for (auto &th : pool)
+            th.join();
+    }
+}
+
+spatial_index::spatial_index(double cell_degrees) : cell_deg(cell_degrees)
+{
+    if (cell_degrees <= 0 || cell_degrees > 180)
+    {
+        throw std::invalid_argument("spatial_index cell size must be in (0, 180] degrees");
+    }
+    columns = (int64_t)std::ceil(360.0 / cell_deg);
+    rows = (int64_t)std::ceil(180.0 / cell_deg);
+}
+
+int64_t spatial_index::row_of(double lat) const
+{
+    return std::clamp((int64_t)std::floor((lat + 90.0) / cell_deg), (int64_t)0, rows - 1);
+}
+
+int64_t spatial_index::col_of(double lon) const
+{
+    return std::clamp((int64_t)std::floor((lon + 180.0) / cell_deg), (int64_t)0, columns - 1);
+}
+
+void spatial_index::build(const std::vector<measurement> &records, unsigned n_threads)
+{
+    std::vector<keys> ks;
+    std::vector<core> locations;
+    ks.reserve(records.size());
+    locations.reserve(records.size());
+    for (const auto &m : records)
+    {
+        ks.push_back(m.key);
+        locations.push_back(m.core_data);
+    }
+    build(ks, locations, n_threads);
+}
+
+void spatial_index::build(const std::vector<keys> &ks, const std::vector<core> &locations, unsigned n_threads)
+{
+    if (ks.size() != locations.size())
+    {
+        throw std::invalid_argument("spatial_index::build needs one location per key");
+    }
+    if (n_threads == 0)
+        n_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    const size_t n = ks.size();
+    std::vector<std::pair<uint64_t, size_t>> order(n);
+
+    // 1. Cell id of every entry, then sort each chunk locally
+    std::vector<size_t> bounds;
+    size_t chunk = (n + n_threads - 1) / std::max(1u, n_threads);
+    for (size_t b = 0; b < n; b += chunk)
+        bounds.push_back(b);
+    bounds.push_back(n);
+
+    parallel_chunks(n, n_threads, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const core &c = locations[i];
+            bool absent = c.lat == 0 && c.lon == 0;
+            uint64_t id = absent ? missing_cell : (uint64_t)(row_of(c.lat) * columns + col_of(c.lon));
+            order[i] = {id, i};
+        }
+        std::sort(order.begin() + begin, order.begin() + end);
+    });
+
+    // 2. Merge neighbouring sorted chunks, one round of parallel merges at a time
+    while (bounds.size() > 2)
+    {
+        std::vector<std::thread> pool;
+        std::vector<size_t> merged;
+        for (size_t j = 0; j + 2 < bounds.size(); j += 2)
+        {
+            size_t lo = bounds[j], mid = bounds[j + 1], hi = bounds[j + 2];
+            pool.emplace_back([&order, lo, mid, hi] {
+                std::inplace_merge(order.begin() + lo, order.begin() + mid, order.begin() + hi);
+            });
+            merged.push_back(lo);
+        }
+        if (bounds.size() % 2 == 0)
+            merged.push_back(bounds[bounds.size() - 2]); // odd chunk out waits for the next round
+        merged.push_back(n);
+        for (auto &th : pool)
+            th.join();
+        bounds = std::move(merged);
+    }
+
+    // 3. Entries without a location sorted to the end; drop them and gather the rest
+    size_t kept =
+        std::lower_bound(order.begin(), order.end(), std::make_pair(missing_cell, (size_t)0)) - order.begin();
+    cell_ids.resize(kept);
+    lats.resize(kept);
+    lons.resize(kept);
+    entry_keys.resize(kept);
+    entry_cores.resize(kept);
+
+    parallel_chunks(kept, n_threads, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            size_t src = order[i].second;
+            cell_ids[i] = order[i].first;
+            lats[i] = locations[src].lat;
+            lons[i] = locations[src].lon;
+            entry_keys[i] = ks[src];
+            entry_cores[i] = locations[src];
+        }
+    });
+}
+
+std::vector<size_t> spatial_index::within_box(double min_lat, double min_lon, double max_lat, double max_lon) const
+{
+    std::vector<size_t> hits;
+    for_each_in_box(min_lat, min_lon, max_lat, max_lon, [&](size_t i) { hits.push_back(i); });
+    return hits;
+}
+
+std::vector<size_t> spatial_index::within_radius(double lat, double lon, double radius_m) const
+{
+    // Bounding box of the circle, widened in longitude by the latitude furthest from the equator
+    double dlat = radius_m / (earth_radius_m * deg_to_rad);
+    double min_lat = std::max(-90.0, lat - dlat), max_lat = std::min(90.0, lat + dlat);
+    double min_lon = -180.0, max_lon = 180.0;
+
+    double widest = std::max(std::abs(min_lat), std::abs(max_lat));
+    if (widest < 90.0)
+    {
+        double dlon = dlat / std::cos(widest * deg_to_rad);
+        if (dlon < 180.0)
+        {
+            min_lon = lon - dlon;
+            max_lon = lon + dlon;
+            if (min_lon < -180.0)
+                min_lon += 360.0;
+            if (max_lon > 180.0)
+                max_lon -= 360.0;
+        }
+    }
+
+    std::vector<size_t> hits;
+    for_each_in_box(min_lat, min_lon, max_lat, max_lon, [&](size_t i) {
+        if (haversine_m(lat, lon, lats[i], lons[i]) <= radius_m)
+            hits.push_back(i);
+    });
+    return hits;
+}
+
+double spatial_index::haversine_m(double lat1, double lon1, double lat2, double lon2)
+{
+    double dphi = (lat2 - lat1) * deg_to_rad;
+    double dlambda = (lon2 - lon1) * deg_to_rad;
+    double h = std::sin(dphi / 2) * std::sin(dphi / 2) + std::cos(lat1 * deg_to_rad) * std::cos(lat2 * deg_to_rad) *
+                                                             std::sin(dlambda / 2) * std::sin(dlambda / 2);
+    return 2 * earth_radius_m * std::asin(std::sqrt(std::min(1.0, h)));
+}
@@ -0,0 +1,154 @@
+#include "inference/inference_engine.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+torch::jit::Module inference_engine::optimize_module(torch::jit::Module module)
+{
+    module.eval();
+    auto frozen = torch::jit::freeze(module);
+    return torch::jit::optimize_for_inference(frozen);
+}
+
+void inference_engine::to_channels_last(torch::jit::Module &module)
+{
+    torch::NoGradGuard no_grad;
+    for (auto p : module.parameters())
+    {
+        if (p.dim() == 4 && p.is_floating_point())
+            p.set_data(p.contiguous(torch::MemoryFormat::ChannelsLast));
+    }
+}
+
+torch::Tensor inference_engine::prepare_input(torch::Tensor batch) const
+{
+    if (options.channels_last && batch.dim() == 4)
+        return batch.contiguous(torch::MemoryFormat::ChannelsLast);
+    return batch;
+}
+
+inference_engine::inference_engine(torch::jit::Module module, inference_engine_options options)
+    : options(options), queue(options.window, options.max_batch)
+{
+    if (options.replicas < 1 || options.max_batch < 1)
+    {
+        throw std::invalid_argument("inference_engine needs at least one replica and a batch size of at least 1");
+    }
+
+    int intra_op = options.intra_op_threads;
+    if (intra_op <= 0)
+        intra_op = std::max(1, (int)std::thread::hardware_concurrency() / options.replicas);
+    at::set_num_threads(intra_op);
+
+    // A jit::Module is a handle: without the clone, eval() and to_channels_last() would
+    // change the caller's module (and its parameters) too
+    module = module.clone();
+    if (options.channels_last)
+        to_channels_last(module);
+    auto prepared = options.optimize ? optimize_module(module) : module;
+    if (!options.optimize)
+        prepared.eval();
+
+    // Replicas share nothing, so workers never contend on one graph executor
+    for (int r = 0; r < options.replicas; ++r)
+        modules.push_back(r == 0 ? prepared : prepared.clone());
+
+    // Warm-up: the first runs at each shape pay for profiling, fusion and allocation
+    {
+        c10::InferenceMode guard;
+        for (auto &m : modules)
+        {
+            for (int64_t b : {(int64_t)1, options.max_batch})
+            {
+                std::vector<int64_t> shape = {b};
+                shape.insert(shape.end(), options.example_shape.begin(), options.example_shape.end());
+                auto x = prepare_input(torch::randn(shape));
+                for (int i = 0; i < options.warmup_runs; ++i)
+                    m.forward({x});
+            }
+        }
+    }
+
+    // Throughput is measured from here, not from before the warm-up
+    latencies.restart();
+    for (int r = 0; r < options.replicas; ++r)
+        workers.emplace_back(&inference_engine::worker_loop, this, (size_t)r);
+}
+
+std::unique_ptr<inference_engine> inference_engine::load(const std::string &path, inference_engine_options options)
+{
+    return std::make_unique<inference_engine>(torch::jit::load(path), options);
+}
+
+inference_engine::~inference_engine()
+{
+    queue.close();
+    for (auto &w : workers)
+    {
+        if (w.joinable())
+            w.join();
+    }
+}
+
+std::future<torch::Tensor> inference_engine::submit(torch::Tensor example)
+{
+    if (example.sizes() != torch::IntArrayRef(options.example_shape))
+    {
+        throw std::invalid_argument("inference_engine example must be shaped like example_shape");
+    }
+
+    request r;
+    r.example = std::move(example);
+    auto output = r.output.get_future();
+    if (!queue.push(std::move(r)))
+    {
+        throw std::runtime_error("inference_engine is shutting down");
+    }
+    return output;
+}
+
+torch::Tensor inference_engine::infer(torch::Tensor example)
+{
+    return submit(std::move(example)).get();
+}
+
+void inference_engine::worker_loop(size_t replica)
+{
+    c10::InferenceMode guard;
+    std::vector<request> batch;
+    batch.reserve(options.max_batch);
+
+    while (queue.next(batch))
+    {
+        run_batch(modules[replica], batch);
+        batch.clear();
+    }
+}
+
+void inference_engine::run_batch(torch::jit::Module &module, std::vector<request> &batch)
+{
+    torch::Tensor output;
+    try
+    {
+        std::vector<torch::Tensor> examples;
+        examples.reserve(batch.size());
+        for (auto &r : batch)
+            examples.push_back(r.example);
+        output = module.forward({prepare_input(torch::stack(examples))}).toTensor();
+    }
+    catch (...)
+    {
+        for (auto &r : batch)
+            r.output.set_exception(std::current_exception());
+        return;
+    }
+
+    auto done = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < batch.size(); ++i)
+        batch[i].output.set_value(output[(int64_t)i]);
+    latencies.record(batch, done);
+}
+
+inference_stats inference_engine::stats()
+{
+    return latencies.stats();
+}
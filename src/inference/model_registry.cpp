@@ -0,0 +1,173 @@
+#include "inference/model_registry.hpp"
+#include "inference/inference_engine.hpp"
+#include <ATen/Version.h>
+#include <torch/version.h>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace
+{
+    const char *stage_file = "registry/stage";
+
+    // 64-bit FNV-1a; only needs to separate environments, not resist collisions by design
+    std::string fnv1a_hex(const std::string &text)
+    {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (unsigned char c : text)
+        {
+            h ^= c;
+            h *= 0x100000001b3ULL;
+        }
+        char out[17];
+        std::snprintf(out, sizeof(out), "%016llx", (unsigned long long)h);
+        return out;
+    }
+
+    // Writes to a private temporary name and renames, so concurrent processes never read a partial file
+    void save_atomically(torch::jit::Module &module, const std::string &path, const std::string &stage)
+    {
+        std::string tmp = path + ".tmp." + std::to_string(::getpid());
+        torch::jit::ExtraFilesMap extra = {{stage_file, stage}};
+        module.save(tmp, extra);
+        std::filesystem::rename(tmp, path);
+    }
+}
+
+std::string model_registry::environment_key()
+{
+    return std::string("torch=") + TORCH_VERSION + ";cpu=" + at::get_cpu_capability() +
+           ";mkldnn=" + at::get_mkldnn_version();
+}
+
+std::string model_registry::cache_path(const std::string &model_path, const model_registry_options &options)
+{
+    namespace fs = std::filesystem;
+    std::ostringstream key;
+    key << environment_key() << ";channels_last=" << options.channels_last << ";size=" << fs::file_size(model_path)
+        << ";mtime=" << fs::last_write_time(model_path).time_since_epoch().count();
+
+    fs::path source(model_path);
+    auto cached = source.parent_path() / (source.stem().string() + "." + fnv1a_hex(key.str()) + ".opt.pt");
+    return cached.string();
+}
+
+std::shared_ptr<served_model> model_registry::load_model(const std::string &path, const model_registry_options &options)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto model = std::make_shared<served_model>();
+    model->source_path = path;
+
+    if (options.use_cache)
+    {
+        model->cache_path = cache_path(path, options);
+        if (std::filesystem::exists(model->cache_path))
+        {
+            try
+            {
+                torch::jit::ExtraFilesMap extra = {{stage_file, ""}};
+                auto module = torch::jit::load(model->cache_path, c10::nullopt, extra);
+                model->module = extra[stage_file] == "optimized" ? module : torch::jit::optimize_for_inference(module);
+                model->from_cache = true;
+            }
+            catch (const c10::Error &error)
+            {
+                // A corrupt or foreign artefact is rebuilt below
+                std::cerr << "Ignoring unreadable model cache " << model->cache_path << ": " << error.what_without_backtrace()
+                          << "\n";
+            }
+        }
+    }
+
+    if (!model->from_cache)
+    {
+        auto module = torch::jit::load(path);
+        module.eval();
+        if (options.channels_last)
+            inference_engine::to_channels_last(module);
+        auto frozen = torch::jit::freeze(module);
+
+        // optimize_for_inference rewrites an already frozen module in place, so keep a copy
+        auto frozen_copy = frozen.clone();
+        model->module = torch::jit::optimize_for_inference(frozen);
+
+        if (options.use_cache)
+        {
+            try
+            {
+                try
+                {
+                    save_atomically(model->module, model->cache_path, "optimized");
+                }
+                catch (const c10::Error &)
+                {
+                    // MKLDNN-packed weights are not serialisable; the frozen graph still saves the freeze
+                    save_atomically(frozen_copy, model->cache_path, "frozen");
+                }
+            }
+            catch (const std::exception &error)
+            {
+                // A read-only model directory only costs the next start its cache
+                std::cerr << "Could not write model cache " << model->cache_path << ": " << error.what() << "\n";
+            }
+        }
+    }
+
+    model->load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return model;
+}
+
+model_registry::entry &model_registry::find(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(entries_mutex);
+    auto it = entries.find(name);
+    if (it == entries.end())
+    {
+        throw std::out_of_range("No model registered as: " + name);
+    }
+    return *it->second;
+}
+
+void model_registry::add(const std::string &name, const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(entries_mutex);
+    auto &e = entries[name];
+    if (!e)
+        e = std::make_unique<entry>();
+    std::lock_guard<std::mutex> load_lock(e->load_mutex);
+    e->path = path;
+}
+
+std::shared_ptr<served_model> model_registry::get(const std::string &name)
+{
+    auto &e = find(name);
+    auto current = std::atomic_load(&e.current);
+    if (current)
+        return current;
+
+    // First use: one caller loads, the others wait for it instead of loading again
+    std::lock_guard<std::mutex> lock(e.load_mutex);
+    current = std::atomic_load(&e.current);
+    if (!current)
+    {
+        current = load_model(e.path, options);
+        std::atomic_store(&e.current, current);
+    }
+    return current;
+}
+
+void model_registry::swap(const std::string &name, const std::string &path)
+{
+    auto &e = find(name);
+
+    // The slow part runs before any lock, while readers keep using the old version
+    auto next = load_model(path, options);
+
+    std::lock_guard<std::mutex> lock(e.load_mutex);
+    e.path = path;
+    std::atomic_store(&e.current, next);
+}
@@ -0,0 +1,73 @@
+#include "serving/micro_batcher.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr int sub_buckets = 16;
+    constexpr int octaves = 48;
+
+    // Bucket 0 holds < 1 µs; then 16 linear slices of every [2^o, 2^(o+1)) µs octave
+    int bucket_of(double us)
+    {
+        if (us < 1.0)
+            return 0;
+        int octave = std::min(octaves - 1, (int)std::floor(std::log2(us)));
+        int sub = std::min(sub_buckets - 1, (int)((us / std::ldexp(1.0, octave) - 1.0) * sub_buckets));
+        return 1 + octave * sub_buckets + sub;
+    }
+
+    double bucket_upper_us(int bucket)
+    {
+        if (bucket == 0)
+            return 1.0;
+        int octave = (bucket - 1) / sub_buckets, sub = (bucket - 1) % sub_buckets;
+        return std::ldexp(1.0, octave) * (1.0 + (sub + 1) / (double)sub_buckets);
+    }
+}
+
+latency_recorder::latency_recorder()
+    : requests(0), batches(0), latency_sum_us(0), latency_max_us(0), histogram(1 + octaves * sub_buckets, 0),
+      started(std::chrono::steady_clock::now())
+{
+}
+
+void latency_recorder::restart()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    started = std::chrono::steady_clock::now();
+}
+
+void latency_recorder::add(double us)
+{
+    latency_sum_us += us;
+    latency_max_us = std::max(latency_max_us, us);
+    histogram[bucket_of(us)]++;
+}
+
+serving_stats latency_recorder::stats()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    serving_stats s;
+    s.requests = requests;
+    s.batches = batches;
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    s.requests_per_second = elapsed > 0 ? requests / elapsed : 0;
+    s.mean_batch_size = batches > 0 ? (double)requests / batches : 0;
+    s.mean_latency_us = requests > 0 ? latency_sum_us / requests : 0;
+    s.max_latency_us = latency_max_us;
+
+    auto percentile = [&](double q) {
+        int64_t target = (int64_t)std::ceil(q * requests), seen = 0;
+        for (int bucket = 0; bucket < (int)histogram.size(); ++bucket)
+        {
+            seen += histogram[bucket];
+            if (seen >= target && seen > 0)
+                return std::min(bucket_upper_us(bucket), latency_max_us);
+        }
+        return 0.0;
+    };
+    s.p50_latency_us = percentile(0.50);
+    s.p99_latency_us = percentile(0.99);
+    return s;
+}
@@ -0,0 +1,39 @@
+#include "trace/torch_events.hpp"
+#include "trace/trace.hpp"
+#include <memory>
+
+namespace
+{
+    struct span_start : public at::ObserverContext {
+        int64_t start_ns;
+
+        explicit span_start(int64_t start_ns) : start_ns(start_ns) {}
+    };
+
+    std::unique_ptr<at::ObserverContext> on_enter(const at::RecordFunction &)
+    {
+        if (!tracer::enabled())
+            return nullptr;
+        return std::make_unique<span_start>(tracer::now_ns());
+    }
+
+    void on_exit(const at::RecordFunction &fn, at::ObserverContext *ctx)
+    {
+        if (!ctx)
+            return;
+        // Operator names are owned by the dispatcher and live as long as the process
+        tracer::record(fn.name(), "torch", static_cast<span_start *>(ctx)->start_ns, tracer::now_ns());
+    }
+}
+
+torch_events::torch_events()
+{
+    // Operators only: user scopes may carry names that do not outlive the call
+    handle = at::addGlobalCallback(
+        at::RecordFunctionCallback(on_enter, on_exit).needsInputs(false).scopes({at::RecordScope::FUNCTION}));
+}
+
+torch_events::~torch_events()
+{
+    at::removeCallback(handle);
+}
@@ -0,0 +1,219 @@
+#include "trace/trace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+
+std::atomic<bool> tracer::active{false};
+
+namespace
+{
+    // One thread's spans for one session. Only the owning thread writes; 'head' counts
+    // every span ever written, so head - capacity of them are gone once it wraps.
+    struct ring {
+        std::vector<trace_event> events;
+        std::atomic<uint64_t> head{0};
+        uint64_t session;
+
+        ring(size_t capacity, uint64_t session) : events(capacity), session(session) {}
+    };
+
+    struct registry {
+        std::mutex mutex;
+        std::vector<std::shared_ptr<ring>> rings;
+        std::atomic<uint64_t> session{0};
+        size_t capacity = 1 << 18;
+        int64_t started_ns = 0;
+        std::atomic<uint32_t> next_tid{1};
+    };
+
+    registry &global()
+    {
+        static registry r;
+        return r;
+    }
+
+    uint32_t thread_id()
+    {
+        thread_local uint32_t tid = global().next_tid++;
+        return tid;
+    }
+
+    // The calling thread's ring for the current session, registered on first use. A ring
+    // left over from an earlier session is simply replaced; its owner holds the only
+    // other reference, so a span still being written into it is harmless.
+    ring &local_ring()
+    {
+        thread_local std::shared_ptr<ring> local;
+        auto &reg = global();
+        uint64_t session = reg.session.load(std::memory_order_acquire);
+        if (!local || local->session != session)
+        {
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            local = std::make_shared<ring>(reg.capacity, session);
+            reg.rings.push_back(local);
+        }
+        return *local;
+    }
+
+    void write_escaped(std::ostream &out, const char *s)
+    {
+        for (; *s; ++s)
+        {
+            if (*s == '"' || *s == '\\')
+                out << '\\' << *s;
+            else if ((unsigned char)*s < 0x20)
+                out << ' ';
+            else
+                out << *s;
+        }
+    }
+}
+
+void tracer::start(size_t events_per_thread)
+{
+    if (events_per_thread == 0)
+        throw std::invalid_argument("tracer::start: events_per_thread must be positive");
+
+    auto &reg = global();
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.rings.clear();
+        reg.capacity = events_per_thread;
+        reg.started_ns = now_ns();
+        reg.session.fetch_add(1, std::memory_order_release);
+    }
+    active.store(true, std::memory_order_release);
+}
+
+void tracer::stop()
+{
+    active.store(false, std::memory_order_release);
+}
+
+int64_t tracer::now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void tracer::record(const char *name, const char *category, int64_t start_ns, int64_t end_ns)
+{
+    if (!enabled())
+        return;
+
+    ring &r = local_ring();
+    uint64_t h = r.head.load(std::memory_order_relaxed);
+    trace_event &e = r.events[h % r.events.size()];
+    e.name = name;
+    e.category = category;
+    e.start_ns = start_ns;
+    e.duration_ns = end_ns - start_ns;
+    e.tid = thread_id();
+    r.head.store(h + 1, std::memory_order_release);
+}
+
+std::vector<trace_event> tracer::collect()
+{
+    std::vector<trace_event> events;
+    auto &reg = global();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (const auto &r : reg.rings)
+    {
+        uint64_t h = r->head.load(std::memory_order_acquire);
+        uint64_t cap = r->events.size();
+        for (uint64_t i = h > cap ? h - cap : 0; i < h; ++i)
+            events.push_back(r->events[i % cap]);
+    }
+    std::sort(events.begin(), events.end(),
+              [](const trace_event &a, const trace_event &b) { return a.start_ns < b.start_ns; });
+    return events;
+}
+
+uint64_t tracer::dropped()
+{
+    uint64_t lost = 0;
+    auto &reg = global();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (const auto &r : reg.rings)
+    {
+        uint64_t h = r->head.load(std::memory_order_acquire);
+        if (h > r->events.size())
+            lost += h - r->events.size();
+    }
+    return lost;
+}
+
+void tracer::write_chrome_trace(const std::string &path)
+{
+    auto events = collect();
+    int64_t origin = global().started_ns;
+
+    std::ofstream out(path);
+    if (!out)
+        throw std::runtime_error("Could not open trace output: " + path);
+
+    // Timestamps are microseconds since start(); three decimals keep nanosecond resolution
+    char buffer[64];
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    std::set<uint32_t> tids;
+    bool first = true;
+    for (const auto &e : events)
+    {
+        tids.insert(e.tid);
+        out << (first ? "" : ",\n") << "{\"name\":\"";
+        write_escaped(out, e.name);
+        out << "\",\"cat\":\"";
+        write_escaped(out, e.category);
+        std::snprintf(buffer, sizeof(buffer), "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f",
+                      (e.start_ns - origin) / 1000.0, e.duration_ns / 1000.0);
+        out << buffer << ",\"pid\":1,\"tid\":" << e.tid << "}";
+        first = false;
+    }
+    for (uint32_t tid : tids)
+    {
+        out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+            << ",\"args\":{\"name\":\"thread " << tid << "\"}}";
+        first = false;
+    }
+    out << "\n]}\n";
+}
+
+trace_session::trace_session(const std::string &path, size_t events_per_thread) : path(path)
+{
+    if (!path.empty())
+        tracer::start(events_per_thread);
+}
+
+trace_session::~trace_session()
+{
+    if (path.empty())
+        return;
+
+    tracer::stop();
+    try
+    {
+        tracer::write_chrome_trace(path);
+        std::cerr << "Trace written to " << path;
+        if (uint64_t lost = tracer::dropped())
+            std::cerr << " (" << lost << " oldest spans overwritten)";
+        std::cerr << "\n";
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Warning: " << e.what() << "\n";
+    }
+}
+
+std::string trace_session::path_from_env()
+{
+    const char *path = std::getenv("TRACE_OUT");
+    return path ? path : "";
+}
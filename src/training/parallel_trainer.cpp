@@ -0,0 +1,197 @@
+#include "training/parallel_trainer.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+void parallel_trainer::barrier::arrive_and_wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    uint64_t arrived_in = generation;
+    if (++waiting == count)
+    {
+        waiting = 0;
+        generation++;
+        cv.notify_all();
+        return;
+    }
+    cv.wait(lock, [&] { return generation != arrived_in; });
+}
+
+parallel_trainer::parallel_trainer(std::shared_ptr<torch::nn::Module> model, trainer_loss_fn loss_fn, int n_workers)
+    : model(model), loss_fn(std::move(loss_fn)),
+      n_workers(n_workers > 0 ? n_workers : (int)std::max(1u, std::thread::hardware_concurrency())),
+      generation(0), finished(0), stopping(false), sync(this->n_workers)
+{
+    if (!model)
+    {
+        throw std::invalid_argument("parallel_trainer needs a model");
+    }
+
+    replicas.push_back(model);
+    for (int w = 1; w < this->n_workers; ++w)
+        replicas.push_back(model->clone()); // throws for modules that are not Cloneable
+    for (auto &replica : replicas)
+    {
+        parameters.push_back(replica->parameters());
+        buffers.push_back(replica->buffers());
+    }
+
+    shard_begin.resize(this->n_workers);
+    shard_end.resize(this->n_workers);
+    shard_loss.resize(this->n_workers);
+    errors.resize(this->n_workers);
+    for (int w = 0; w < this->n_workers; ++w)
+        workers.emplace_back(&parallel_trainer::worker_loop, this, w);
+}
+
+parallel_trainer::~parallel_trainer()
+{
+    {
+        std::lock_guard<std::mutex> lock(step_mutex);
+        stopping = true;
+    }
+    step_cv.notify_all();
+    for (auto &t : workers)
+    {
+        if (t.joinable())
+            t.join();
+    }
+}
+
+double parallel_trainer::step(const torch::Tensor &input, const torch::Tensor &target)
+{
+    const int64_t rows = input.size(0);
+    if (rows < n_workers || target.size(0) != rows)
+    {
+        throw std::invalid_argument("parallel_trainer batch needs matching input/target rows, at least one per worker");
+    }
+
+    this->input = input;
+    this->target = target;
+    for (int w = 0; w < n_workers; ++w)
+    {
+        shard_begin[w] = rows * w / n_workers;
+        shard_end[w] = rows * (w + 1) / n_workers;
+        errors[w] = nullptr;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(step_mutex);
+        finished = 0;
+        generation++;
+        step_cv.notify_all();
+        done_cv.wait(lock, [&] { return finished == n_workers; });
+    }
+
+    for (auto &error : errors)
+    {
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    double total = 0;
+    for (double l : shard_loss)
+        total += l;
+    return total / rows;
+}
+
+void parallel_trainer::worker_loop(int w)
+{
+    // Cores are split between workers; with OpenMP the setting is per calling thread
+    at::set_num_threads(std::max(1, (int)std::thread::hardware_concurrency() / n_workers));
+
+    uint64_t seen = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(step_mutex);
+            step_cv.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+        }
+
+        try
+        {
+            forward_backward(w);
+        }
+        catch (...)
+        {
+            errors[w] = std::current_exception();
+        }
+
+        // Every shard's gradient must exist before any slice is reduced
+        sync.arrive_and_wait();
+
+        bool failed = std::any_of(errors.begin(), errors.end(), [](const std::exception_ptr &e) { return (bool)e; });
+        if (!failed)
+        {
+            try
+            {
+                all_reduce(w);
+            }
+            catch (...)
+            {
+                errors[w] = std::current_exception();
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(step_mutex);
+        if (++finished == n_workers)
+            done_cv.notify_one();
+    }
+}
+
+void parallel_trainer::forward_backward(int w)
+{
+    auto &params = parameters[w];
+    {
+        torch::NoGradGuard no_grad;
+        if (w > 0)
+        {
+            for (size_t i = 0; i < params.size(); ++i)
+                params[i].copy_(parameters[0][i]);
+            for (size_t i = 0; i < buffers[w].size(); ++i)
+                buffers[w][i].copy_(buffers[0][i]);
+        }
+        // Zero rather than reset, so the gradient buffers are reused across steps
+        for (auto &p : params)
+        {
+            if (p.grad().defined())
+                p.mutable_grad().zero_();
+        }
+    }
+
+    auto x = input.slice(0, shard_begin[w], shard_end[w]);
+    auto y = target.slice(0, shard_begin[w], shard_end[w]);
+    auto loss = loss_fn(*replicas[w], x, y);
+    loss.backward();
+    shard_loss[w] = loss.item<double>() * (shard_end[w] - shard_begin[w]);
+}
+
+void parallel_trainer::all_reduce(int w)
+{
+    torch::NoGradGuard no_grad;
+    const double rows = (double)input.size(0);
+
+    for (size_t i = 0; i < parameters[0].size(); ++i)
+    {
+        auto total = parameters[0][i].grad();
+        if (!total.defined())
+            continue; // parameter not used by the loss
+
+        // This worker's slice of the flattened gradient
+        const int64_t numel = total.numel();
+        const int64_t begin = numel * w / n_workers, end = numel * (w + 1) / n_workers;
+        if (begin == end)
+            continue;
+
+        auto slice = total.view(-1).slice(0, begin, end);
+        slice.mul_((shard_end[0] - shard_begin[0]) / rows);
+        for (int r = 1; r < n_workers; ++r)
+        {
+            auto g = parameters[r][i].grad();
+            if (g.defined())
+                slice.add_(g.view(-1).slice(0, begin, end), (shard_end[r] - shard_begin[r]) / rows);
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#include "unsupervised/batch_source.hpp"
+#include <sstream>
+#include <stdexcept>
+
+torch::Tensor tensor_batch_source::next()
+{
+    if (offset >= data.size(0))
+        return torch::Tensor();
+
+    auto end = std::min(offset + batch_size, data.size(0));
+    auto batch = data.slice(0, offset, end);
+    offset = end;
+    return batch;
+}
+
+void tensor_batch_source::reset()
+{
+    offset = 0;
+}
+
+csv_batch_source::csv_batch_source(const std::string &path, std::vector<int> column_indices, int64_t batch_size)
+    : path(path), column_indices(std::move(column_indices)), batch_size(batch_size), file(path), skipped(0)
+{
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Could not open dataset at: " + path);
+    }
+    buffer = torch::empty({batch_size, (int64_t)this->column_indices.size()}, torch::kFloat);
+}
+
+torch::Tensor csv_batch_source::next()
+{
+    auto acc = buffer.accessor<float, 2>();
+    int max_column = 0;
+    for (int c : column_indices)
+        max_column = std::max(max_column, c);
+
+    std::string line;
+    std::string field;
+    std::vector<float> row(max_column + 1);
+    int64_t rows = 0;
+    while (rows < batch_size && std::getline(file, line))
+    {
+        if (line.empty())
+            continue;
+
+        std::stringstream ss(line);
+        try
+        {
+            int col = 0;
+            while (col <= max_column && std::getline(ss, field, ','))
+            {
+                row[col] = field.empty() ? 0.0f : std::stof(field);
+                ++col;
+            }
+            if (col <= max_column)
+                throw std::invalid_argument("not enough columns");
+        }
+        catch (const std::exception &)
+        {
+            // Header or malformed line
+            ++skipped;
+            continue;
+        }
+
+        for (size_t j = 0; j < column_indices.size(); ++j)
+            acc[rows][j] = row[column_indices[j]];
+        ++rows;
+    }
+
+    if (rows == 0)
+        return torch::Tensor();
+    return buffer.slice(0, 0, rows);
+}
+
+void csv_batch_source::reset()
+{
+    file.clear();
+    file.seekg(0);
+    skipped = 0;
+}
@@ -0,0 +1,347 @@
+#include "unsupervised/bounded_kmeans.hpp"
+#include "unsupervised/kmeans.hpp"
+#include <ATen/CPUGeneratorImpl.h>
+#include <ATen/Parallel.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    constexpr int64_t grain_size = 2048;
+    constexpr float infinity = std::numeric_limits<float>::infinity();
+
+    inline float euclidean(const float *x, const float *c, int64_t d)
+    {
+        float acc = 0.0f;
+        for (int64_t j = 0; j < d; ++j)
+        {
+            float diff = x[j] - c[j];
+            acc += diff * diff;
+        }
+        return std::sqrt(acc);
+    }
+
+    // Data and centroid buffers shared by both variants. Everything is contiguous
+    // float on CPU so the bound loops can work on raw pointers.
+    struct bounded_state {
+        torch::Tensor data, labels, ones;
+        torch::Tensor centroids, new_centroids, sums, counts;
+        int64_t n, d;
+        int K;
+
+        bounded_state(const torch::Tensor &projected, int K, uint64_t seed, const torch::Tensor &init) : K(K)
+        {
+            data = projected.to(torch::kCPU, torch::kFloat).contiguous();
+            n = data.size(0);
+            d = data.size(1);
+            if (K < 1 || K > n)
+                throw std::invalid_argument("k-means needs 1 <= K <= number of points");
+
+            if (init.defined())
+            {
+                if (init.dim() != 2 || init.size(0) != K || init.size(1) != d)
+                    throw std::invalid_argument("k-means initial centroids must be [K, D]");
+                centroids = init.to(torch::kCPU, torch::kFloat).clone().contiguous();
+            }
+            else
+            {
+                auto generator = at::make_generator<at::CPUGeneratorImpl>(seed);
+                auto perm = torch::randperm(n, generator, torch::kLong);
+                centroids = data.index_select(0, perm.slice(0, 0, K)).contiguous();
+            }
+            new_centroids = torch::empty_like(centroids);
+            sums = torch::empty_like(centroids);
+            counts = torch::empty({K}, data.options());
+            labels = torch::empty({n}, torch::kLong);
+            ones = torch::ones({n}, data.options());
+        }
+
+        // Moves every centroid to the mean of its members, records how far each one
+        // moved in 'moved' and returns the total shift (same measure as kmeans()).
+        float update(std::vector<float> &moved)
+        {
+            kmeans_update(data, labels, centroids, ones, sums, counts, new_centroids);
+            auto p = (new_centroids - centroids).square().sum(1).sqrt().contiguous();
+            std::copy(p.data_ptr<float>(), p.data_ptr<float>() + K, moved.begin());
+            std::swap(centroids, new_centroids);
+            return p.square().sum().sqrt().item<float>();
+        }
+
+        // Half the distance between every pair of centroids [K, K].
+        torch::Tensor half_centroid_distances() const
+        {
+            // compute_mode 2: never use the matmul shortcut, the bounds need exact distances
+            return torch::cdist(centroids, centroids, 2.0, 2).mul_(0.5f).contiguous();
+        }
+    };
+
+    // Half the distance from every centroid to its closest other centroid [K].
+    torch::Tensor half_separation(const torch::Tensor &half_cc)
+    {
+        return half_cc.clone().fill_diagonal_(infinity).amin(1).contiguous();
+    }
+
+    void report(const char *name, const kmeans_stats &s)
+    {
+        double total = (double)s.distances_computed + (double)s.distances_skipped;
+        std::cout << "\n" << name << " converged after " << s.iterations << " iterations. Computed "
+                  << s.distances_computed << " of " << (int64_t)total << " point-centroid distances ("
+                  << (total > 0 ? 100.0 * s.distances_skipped / total : 0.0) << "% skipped).\n";
+    }
+}
+
+torch::Tensor kmeans_hamerly(torch::Tensor projected, int K, int max_iters, float tol, kmeans_stats *stats, bool verbose,
+                             uint64_t seed, const torch::Tensor &init_centroids)
+{
+    if (verbose)
+        std::cout << "=== Hamerly K-Means ===\n\n";
+
+    bounded_state s(projected, K, seed, init_centroids);
+    const int64_t n = s.n, d = s.d;
+    const float *X = s.data.data_ptr<float>();
+    int64_t *A = s.labels.data_ptr<int64_t>();
+
+    std::vector<float> upper(n), lower(n), moved(K);
+    std::atomic<int64_t> computed{0};
+    int64_t passes = 1;
+
+    // 1. Initial assignment computes every distance
+    at::parallel_for(0, n, grain_size, [&](int64_t begin, int64_t end) {
+        const float *C = s.centroids.data_ptr<float>();
+        for (int64_t i = begin; i < end; ++i)
+        {
+            float best_d = infinity, second_d = infinity;
+            int64_t best = 0;
+            for (int k = 0; k < K; ++k)
+            {
+                float dk = euclidean(X + i * d, C + k * d, d);
+                if (dk < best_d)
+                {
+                    second_d = best_d;
+                    best_d = dk;
+                    best = k;
+                }
+                else if (dk < second_d)
+                {
+                    second_d = dk;
+                }
+            }
+            A[i] = best;
+            upper[i] = best_d;
+            lower[i] = second_d;
+        }
+    });
+    computed += n * K;
+
+    int iter;
+    for (iter = 0; iter < max_iters; ++iter)
+    {
+        // 2. Update centroids
+        float shift_val = s.update(moved);
+        if (verbose && (iter % 20 == 0 || iter == max_iters - 1))
+        {
+            std::cout << "Iter " << iter << "  shift = " << shift_val << "\n";
+        }
+
+        // 3. Loosen the bounds by how far the centroids moved. The lower bound drops by the
+        // largest movement, or the second largest if the point's own centroid moved most.
+        int fastest = (int)(std::max_element(moved.begin(), moved.end()) - moved.begin());
+        float max_moved = moved[fastest], second_moved = 0.0f;
+        for (int k = 0; k < K; ++k)
+            if (k != fastest)
+                second_moved = std::max(second_moved, moved[k]);
+
+        auto half_sep_t = half_separation(s.half_centroid_distances());
+        const float *half_sep = half_sep_t.data_ptr<float>();
+
+        // 4. Reassign, only touching points whose bounds overlap
+        at::parallel_for(0, n, grain_size, [&](int64_t begin, int64_t end) {
+            const float *C = s.centroids.data_ptr<float>();
+            int64_t local = 0;
+            for (int64_t i = begin; i < end; ++i)
+            {
+                int64_t a = A[i];
+                upper[i] += moved[a];
+                lower[i] -= (a == fastest) ? second_moved : max_moved;
+
+                float m = std::max(half_sep[a], lower[i]);
+                if (upper[i] <= m)
+                    continue;
+
+                // Tighten the upper bound and test again before scanning every centroid
+                upper[i] = euclidean(X + i * d, C + a * d, d);
+                ++local;
+                if (upper[i] <= m)
+                    continue;
+
+                float best_d = upper[i], second_d = infinity;
+                int64_t best = a;
+                for (int k = 0; k < K; ++k)
+                {
+                    if (k == a)
+                        continue;
+                    float dk = euclidean(X + i * d, C + k * d, d);
+                    ++local;
+                    if (dk < best_d)
+                    {
+                        second_d = best_d;
+                        best_d = dk;
+                        best = k;
+                    }
+                    else if (dk < second_d)
+                    {
+                        second_d = dk;
+                    }
+                }
+                A[i] = best;
+                upper[i] = best_d;
+                lower[i] = second_d;
+            }
+            computed.fetch_add(local, std::memory_order_relaxed);
+        });
+        ++passes;
+
+        // Checked after the reassignment, so the labels always belong to the returned
+        // centroids, as in Lloyd's final assignment
+        if (shift_val < tol)
+            break;
+    }
+
+    kmeans_stats result;
+    result.iterations = std::min(iter + 1, max_iters);
+    result.distances_computed = computed.load();
+    result.distances_skipped = passes * n * K - result.distances_computed;
+    if (verbose)
+        report("Hamerly", result);
+    if (stats)
+        *stats = result;
+    return s.labels;
+}
+
+torch::Tensor kmeans_elkan(torch::Tensor projected, int K, int max_iters, float tol, kmeans_stats *stats, bool verbose,
+                           uint64_t seed, const torch::Tensor &init_centroids)
+{
+    if (verbose)
+        std::cout << "=== Elkan K-Means ===\n\n";
+
+    bounded_state s(projected, K, seed, init_centroids);
+    const int64_t n = s.n, d = s.d;
+    const float *X = s.data.data_ptr<float>();
+    int64_t *A = s.labels.data_ptr<int64_t>();
+
+    std::vector<float> upper(n), lower(n * K), moved(K);
+    std::atomic<int64_t> computed{0};
+    int64_t passes = 1;
+
+    // 1. Initial assignment computes every distance and seeds all K lower bounds
+    at::parallel_for(0, n, grain_size, [&](int64_t begin, int64_t end) {
+        const float *C = s.centroids.data_ptr<float>();
+        for (int64_t i = begin; i < end; ++i)
+        {
+            float *li = lower.data() + i * K;
+            float best_d = infinity;
+            int64_t best = 0;
+            for (int k = 0; k < K; ++k)
+            {
+                li[k] = euclidean(X + i * d, C + k * d, d);
+                if (li[k] < best_d)
+                {
+                    best_d = li[k];
+                    best = k;
+                }
+            }
+            A[i] = best;
+            upper[i] = best_d;
+        }
+    });
+    computed += n * K;
+
+    int iter;
+    for (iter = 0; iter < max_iters; ++iter)
+    {
+        // 2. Update centroids
+        float shift_val = s.update(moved);
+        if (verbose && (iter % 20 == 0 || iter == max_iters - 1))
+        {
+            std::cout << "Iter " << iter << "  shift = " << shift_val << "\n";
+        }
+
+        auto half_cc_t = s.half_centroid_distances();
+        auto half_sep_t = half_separation(half_cc_t);
+        const float *half_cc = half_cc_t.data_ptr<float>();
+        const float *half_sep = half_sep_t.data_ptr<float>();
+
+        // 3. Loosen the bounds, then reassign using the triangle inequality
+        at::parallel_for(0, n, grain_size, [&](int64_t begin, int64_t end) {
+            const float *C = s.centroids.data_ptr<float>();
+            int64_t local = 0;
+            for (int64_t i = begin; i < end; ++i)
+            {
+                float *li = lower.data() + i * K;
+                for (int k = 0; k < K; ++k)
+                    li[k] = std::max(li[k] - moved[k], 0.0f);
+
+                int64_t a = A[i];
+                float u = upper[i] + moved[a];
+                if (u <= half_sep[a])
+                {
+                    upper[i] = u;
+                    continue;
+                }
+
+                bool stale = true;
+                for (int k = 0; k < K; ++k)
+                {
+                    if (k == a)
+                        continue;
+                    float z = std::max(li[k], half_cc[a * K + k]);
+                    if (u <= z)
+                        continue;
+
+                    if (stale)
+                    {
+                        u = euclidean(X + i * d, C + a * d, d);
+                        li[a] = u;
+                        ++local;
+                        stale = false;
+                        if (u <= z)
+                            continue;
+                    }
+
+                    float dk = euclidean(X + i * d, C + k * d, d);
+                    li[k] = dk;
+                    ++local;
+                    if (dk < u)
+                    {
+                        a = k;
+                        u = dk;
+                    }
+                }
+                A[i] = a;
+                upper[i] = u;
+            }
+            computed.fetch_add(local, std::memory_order_relaxed);
+        });
+        ++passes;
+
+        // Only after the reassignment, as in kmeans_hamerly
+        if (shift_val < tol)
+            break;
+    }
+
+    kmeans_stats result;
+    result.iterations = std::min(iter + 1, max_iters);
+    result.distances_computed = computed.load();
+    result.distances_skipped = passes * n * K - result.distances_computed;
+    if (verbose)
+        report("Elkan", result);
+    if (stats)
+        *stats = result;
+    return s.labels;
+}
@@ -0,0 +1,239 @@
+#include "unsupervised/decomposition.hpp"
+#include "trace/trace.hpp"
+#include <ATen/CPUGeneratorImpl.h>
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    // Rows centred per chunk while accumulating the covariance
+    constexpr int64_t covariance_chunk_rows = 65536;
+
+    enum pca_slot
+    {
+        slot_chunk,
+        slot_covariance
+    };
+}
+
+pca_model pca_fit(torch::Tensor data, torch::Tensor *projected, workspace *ws)
+{
+    trace_span span("pca_fit", "pca");
+    torch::NoGradGuard no_grad;
+    workspace local;
+    workspace &buffers = ws ? *ws : local;
+
+    // 1. Determine Device
+    auto device = torch::cuda::is_available() ? torch::kCUDA : torch::kCPU;
+    std::cout << "Running PCA on: " << device << " (cuDNN: "
+              << (torch::cuda::cudnn_is_available() ? "Yes" : "No") << ")\n";
+
+    // 2. Mean ON the device
+    // .to() returns 'data' itself when it is already there, so on CPU nothing is copied
+    auto data_on_device = data.to(device);
+    const int64_t n = data_on_device.size(0), f = data_on_device.size(1);
+    auto mean = data_on_device.mean(0, true);
+
+    // 3. Covariance (N - 1)·C = Σ (x - μ)ᵀ(x - μ), one centred chunk at a time.
+    // Chunks are centred exactly and accumulated in double, so there is no ‖x‖² − nμ²
+    // cancellation and no [N, F] temporary.
+    auto chunk_options = data_on_device.options().dtype(torch::kDouble);
+    auto covariance = buffers.get(slot_covariance, {f, f}, chunk_options).zero_();
+    for (int64_t begin = 0; begin < n; begin += covariance_chunk_rows)
+    {
+        const int64_t rows = std::min(covariance_chunk_rows, n - begin);
+        auto chunk = buffers.get(slot_chunk, {rows, f}, chunk_options);
+        torch::sub_out(chunk, data_on_device.slice(0, begin, begin + rows), mean);
+        covariance.addmm_(chunk.t(), chunk);
+    }
+
+    // 4. Eigendecomposition of the [F, F] covariance: eigenvalues are S²/(N − 1) of the
+    // centred SVD and eigenvectors its right singular vectors. eigh sorts ascending.
+    auto [eigenvalues, eigenvectors] = torch::linalg_eigh(covariance.div_(std::max<int64_t>(1, n - 1)));
+    auto explained_var = eigenvalues.flip(0).clamp_min(0);
+    auto V = eigenvectors.flip(1);
+
+    // 5. Variance Analysis (Logic remains same, move to CPU for the loop)
+    auto total_var = explained_var.sum();
+    auto ratio = (explained_var / total_var).to(torch::kCPU);
+    int max_display = std::min(15, (int)ratio.size(0));
+    float cumulative = 0.0f;
+    int keep_components = 0;
+    std::cout << "Explained variance ratios:\n";
+    for (int i = 0; i < (int)ratio.size(0); ++i)
+    {
+        float pct = ratio[i].item<float>() * 100.0f;
+        cumulative += pct;
+        if (i < max_display)
+        {
+            std::cout << "  PC" << (i + 1) << ": " << pct << "% (cum: " << cumulative << "%)\n";
+        }
+
+        if (cumulative >= 92.0f && keep_components == 0)
+        {
+            keep_components = i + 1;
+        }
+    }
+    if (keep_components == 0)
+        keep_components = std::min(12, (int)ratio.size(0));
+    std::cout << "→ Keeping " << keep_components << " components to explain "
+              << cumulative << "% variance.\n";
+
+    pca_model model;
+    model.mean = mean;
+    model.components = V.slice(1, 0, keep_components).to(data_on_device.scalar_type()).contiguous();
+
+    // 6. Project data: (x − μ)W = xW − μW, one GEMM with the bias folded in
+    if (projected)
+    {
+        auto &out = *projected;
+        if (!out.defined() || out.sizes() != torch::IntArrayRef({n, (int64_t)keep_components}) ||
+            out.options().dtype() != data_on_device.options().dtype() || out.device() != data_on_device.device())
+        {
+            out = torch::empty({n, (int64_t)keep_components}, data_on_device.options());
+        }
+        auto bias = torch::matmul(mean, model.components).neg_();
+        torch::addmm_out(out, bias, data_on_device, model.components);
+    }
+    return model;
+}
+
+torch::Tensor pca(torch::Tensor data)
+{
+    trace_span span("pca", "pca");
+    torch::Tensor projected;
+    pca_fit(data, &projected);
+    return projected;
+}
+
+namespace
+{
+    // The (optionally centred) input as a linear operator. Sparse input is held as CSR
+    // twice, A and Aᵀ, so both products run as row-major sparse × dense kernels.
+    struct centred_operator {
+        torch::Tensor a, at; // [N, F], [F, N]
+        torch::Tensor mean;  // [1, F]
+        bool center;
+
+        // (A - 1μᵀ) X
+        torch::Tensor times(const torch::Tensor &x) const
+        {
+            auto y = torch::mm(a, x);
+            if (center)
+                y.sub_(torch::mm(mean, x));
+            return y;
+        }
+
+        // (A - 1μᵀ)ᵀ Y = AᵀY - μᵀ(1ᵀY)
+        torch::Tensor transpose_times(const torch::Tensor &y) const
+        {
+            auto z = torch::mm(at, y);
+            if (center)
+                z.sub_(torch::mm(mean.t(), y.sum(0, true)));
+            return z;
+        }
+    };
+
+    torch::Tensor orthonormal_basis(const torch::Tensor &y)
+    {
+        return std::get<0>(torch::linalg_qr(y));
+    }
+}
+
+truncated_svd_result truncated_svd(const torch::Tensor &data, int64_t k, const truncated_svd_options &options)
+{
+    trace_span span("truncated_svd", "pca");
+    torch::NoGradGuard no_grad;
+    if (data.dim() != 2)
+    {
+        throw std::invalid_argument("truncated_svd expects a 2-D matrix");
+    }
+    const int64_t n = data.size(0), f = data.size(1);
+    if (k < 1 || k > std::min(n, f))
+    {
+        throw std::invalid_argument("truncated_svd rank must be in [1, min(rows, cols)]");
+    }
+
+    centred_operator op;
+    op.center = options.center;
+    truncated_svd_result result;
+    if (data.is_sparse() || data.layout() == torch::kSparseCsr)
+    {
+        auto coo = (data.is_sparse() ? data : data.to_sparse()).coalesce().to(torch::kFloat);
+        op.a = coo.to_sparse_csr();
+        op.at = coo.t().coalesce().to_sparse_csr();
+        op.mean = torch::mm(op.at, torch::ones({n, 1}, coo.options().layout(torch::kStrided))).t() / (double)n;
+        // ‖A - 1μᵀ‖² = ‖A‖² - n‖μ‖², from the stored values only
+        result.total_ss = coo.values().to(torch::kDouble).pow(2).sum().item<double>();
+        if (op.center)
+            result.total_ss -= n * op.mean.to(torch::kDouble).pow(2).sum().item<double>();
+    }
+    else
+    {
+        op.a = data.to(torch::kFloat).contiguous();
+        op.at = op.a.t();
+        op.mean = op.a.mean(0, true);
+        result.total_ss = (op.center ? op.a - op.mean : op.a).to(torch::kDouble).pow(2).sum().item<double>();
+    }
+    if (!op.center)
+        op.mean = torch::zeros_like(op.mean);
+
+    // 1. Random range finder with subspace (power) iterations, re-orthonormalised each pass
+    const int64_t l = std::min(k + std::max<int64_t>(0, options.oversample), std::min(n, f));
+    auto generator = at::make_generator<at::CPUGeneratorImpl>(options.seed);
+    auto omega = torch::randn({f, l}, generator, torch::kFloat).to(op.mean.device());
+    auto Q = orthonormal_basis(op.times(omega));
+    for (int i = 0; i < options.power_iters; ++i)
+    {
+        Q = orthonormal_basis(op.transpose_times(Q));
+        Q = orthonormal_basis(op.times(Q));
+    }
+
+    // 2. Bᵀ = (QᵀA)ᵀ is [F, l]; its thin SVD Ub S Vbᵀ gives A ≈ (Q Vb) S Ubᵀ
+    auto [Ub, S, Vbh] = torch::linalg_svd(op.transpose_times(Q), false);
+    result.U = torch::mm(Q, Vbh.t()).slice(1, 0, k).contiguous();
+    result.S = S.slice(0, 0, k).contiguous();
+    result.V = Ub.slice(1, 0, k).contiguous();
+    result.mean = op.mean;
+    return result;
+}
+
+pca_model sparse_pca_fit(const torch::Tensor &data, int64_t max_components, torch::Tensor *projected,
+                         const truncated_svd_options &options)
+{
+    trace_span span("sparse_pca_fit", "pca");
+    auto svd = truncated_svd(data, max_components, options);
+
+    // Ratios are against the full variance, so they show what the truncation leaves out
+    auto ratio = (svd.S.to(torch::kDouble).pow(2) / svd.total_ss).to(torch::kCPU);
+    auto r = ratio.accessor<double, 1>();
+    double cumulative = 0.0;
+    int64_t keep_components = 0;
+    std::cout << "Explained variance ratios (sparse, top " << ratio.size(0) << "):\n";
+    for (int64_t i = 0; i < ratio.size(0); ++i)
+    {
+        cumulative += r[i] * 100.0;
+        if (i < 15)
+        {
+            std::cout << "  PC" << (i + 1) << ": " << r[i] * 100.0 << "% (cum: " << cumulative << "%)\n";
+        }
+        if (cumulative >= 92.0 && keep_components == 0)
+        {
+            keep_components = i + 1;
+        }
+    }
+    if (keep_components == 0)
+        keep_components = ratio.size(0);
+    std::cout << "→ Keeping " << keep_components << " of " << ratio.size(0) << " computed components.\n";
+
+    pca_model model;
+    model.mean = svd.mean;
+    model.components = svd.V.slice(1, 0, keep_components).contiguous();
+
+    // The centred projection is U S; no product with the data is needed
+    if (projected)
+        *projected = svd.U.slice(1, 0, keep_components) * svd.S.slice(0, 0, keep_components);
+    return model;
+}
@@ -0,0 +1,40 @@
+#include <torch/torch.h>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include "unsupervised/simulator.hpp"
+
+// Usage: generate_fingerprints <rows> <output path> [seed] [--tensor]
+// Writes a binary snapshot by default, or a torch::save tensor file with --tensor.
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <rows> <output path> [seed] [--tensor]\n";
+        return 1;
+    }
+
+    int64_t rows = std::stoll(argv[1]);
+    std::string path = argv[2];
+    simulator_options options;
+    bool tensor_file = false;
+    for (int i = 3; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--tensor")
+            tensor_file = true;
+        else
+            options.seed = std::stoull(arg);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (tensor_file)
+        simulate_to_tensor_file(path, rows, options);
+    else
+        simulate_to_snapshot(path, rows, options);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Wrote " << rows << " fingerprints (" << simulator_features << " features, seed " << options.seed
+              << ") to " << path << " in " << seconds << " s (" << rows / seconds << " rows/s)\n";
+    return 0;
+}
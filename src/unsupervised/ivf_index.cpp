@@ -0,0 +1,190 @@
+#include "unsupervised/ivf_index.hpp"
+#include "unsupervised/kmeans.hpp"
+#include <ATen/Parallel.h>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+    // Rows assigned per GEMM while building, bounds the [rows, L] distance workspace
+    constexpr int64_t assign_block = 65536;
+
+    inline float squared_l2(const float *a, const float *b, int64_t d)
+    {
+        float acc = 0.0f;
+        for (int64_t j = 0; j < d; ++j)
+        {
+            float diff = a[j] - b[j];
+            acc += diff * diff;
+        }
+        return acc;
+    }
+
+    void check_lists(int n_lists)
+    {
+        if (n_lists < 1)
+        {
+            throw std::invalid_argument("ivf_index: n_lists must be at least 1");
+        }
+    }
+}
+
+void ivf_index::build(const torch::Tensor &data, uint64_t seed, int n_init)
+{
+    check_lists(n_lists);
+    kmeans_options options(n_lists);
+    options.seed = seed;
+    options.n_init = n_init;
+    options.max_iters = 25; // a coarse quantiser does not need a tightly converged fit
+    build(data, kmeans_fit(data, options).centroids);
+}
+
+void ivf_index::build(const torch::Tensor &data, const torch::Tensor &centroids)
+{
+    torch::NoGradGuard no_grad;
+    check_lists(n_lists);
+    if (data.dim() != 2 || centroids.dim() != 2)
+    {
+        throw std::invalid_argument("ivf_index: data and centroids must be 2-D");
+    }
+    auto x = data.to(torch::kCPU, torch::kFloat).contiguous();
+    centroids_ = centroids.to(torch::kCPU, torch::kFloat).contiguous();
+    if (centroids_.size(0) != n_lists || centroids_.size(1) != x.size(1))
+    {
+        throw std::invalid_argument("ivf_index: centroids must be [n_lists, D] with the data's D");
+    }
+    dims = x.size(1);
+    centroid_sq = centroids_.square().sum(1);
+
+    // 1. Assign every vector to its list, block by block
+    auto n = x.size(0);
+    auto labels = torch::empty({n}, torch::kLong);
+    auto dists = torch::empty({std::min(n, assign_block), n_lists}, torch::kFloat);
+    auto min_dists = torch::empty({std::min(n, assign_block)}, torch::kFloat);
+    for (int64_t begin = 0; begin < n; begin += assign_block)
+    {
+        auto end = std::min(n, begin + assign_block);
+        auto block = x.slice(0, begin, end);
+        auto d = dists.slice(0, 0, end - begin);
+        auto md = min_dists.slice(0, 0, end - begin);
+        auto lb = labels.slice(0, begin, end);
+        kmeans_assign(block, block.square().sum(1), centroids_, d, md, lb);
+    }
+
+    // 2. Group the vectors by list
+    ids = torch::argsort(labels);
+    vectors = x.index_select(0, ids).contiguous();
+
+    auto counts = torch::bincount(labels, {}, n_lists).cumsum(0);
+    offsets.assign(n_lists + 1, 0);
+    std::copy(counts.data_ptr<int64_t>(), counts.data_ptr<int64_t>() + n_lists, offsets.begin() + 1);
+}
+
+std::pair<torch::Tensor, torch::Tensor> ivf_index::search(const torch::Tensor &queries, int k, int n_probe) const
+{
+    torch::NoGradGuard no_grad;
+    if (!vectors.defined())
+    {
+        throw std::runtime_error("ivf_index::search called before build");
+    }
+    if (k < 1 || n_probe < 1)
+    {
+        throw std::invalid_argument("ivf_index::search: k and n_probe must be at least 1");
+    }
+    if (queries.dim() != 2 || queries.size(1) != dims)
+    {
+        throw std::invalid_argument("ivf_index::search: queries must be [Q, D] with the indexed D");
+    }
+
+    auto q = queries.to(torch::kCPU, torch::kFloat).contiguous();
+    const int64_t n_queries = q.size(0);
+    n_probe = std::min(n_probe, n_lists);
+
+    // 1. Coarse quantiser: the n_probe closest lists of every query in one GEMM + topk
+    auto coarse = torch::addmm(centroid_sq.unsqueeze(0), q, centroids_.t(), /*beta=*/1, /*alpha=*/-2);
+    auto probes = std::get<1>(coarse.topk(n_probe, 1, /*largest=*/false)).contiguous();
+
+    auto out_dists = torch::full({n_queries, k}, std::numeric_limits<float>::infinity(), torch::kFloat);
+    auto out_ids = torch::full({n_queries, k}, -1, torch::kLong);
+
+    const float *Q = q.data_ptr<float>();
+    const float *V = vectors.data_ptr<float>();
+    const int64_t *I = ids.data_ptr<int64_t>();
+    const int64_t *P = probes.data_ptr<int64_t>();
+    float *OD = out_dists.data_ptr<float>();
+    int64_t *OI = out_ids.data_ptr<int64_t>();
+
+    // 2. Scan the probed lists, keeping the k best in a max-heap per query
+    at::parallel_for(0, n_queries, 16, [&](int64_t begin, int64_t end) {
+        std::vector<std::pair<float, int64_t>> heap;
+        heap.reserve(k);
+        for (int64_t qi = begin; qi < end; ++qi)
+        {
+            heap.clear();
+            const float *query = Q + qi * dims;
+            for (int p = 0; p < n_probe; ++p)
+            {
+                int64_t list = P[qi * n_probe + p];
+                for (int64_t j = offsets[list]; j < offsets[list + 1]; ++j)
+                {
+                    float d = squared_l2(query, V + j * dims, dims);
+                    if ((int)heap.size() < k)
+                    {
+                        heap.emplace_back(d, I[j]);
+                        std::push_heap(heap.begin(), heap.end());
+                    }
+                    else if (d < heap.front().first)
+                    {
+                        std::pop_heap(heap.begin(), heap.end());
+                        heap.back() = {d, I[j]};
+                        std::push_heap(heap.begin(), heap.end());
+                    }
+                }
+            }
+
+            std::sort_heap(heap.begin(), heap.end());
+            for (size_t r = 0; r < heap.size(); ++r)
+            {
+                OD[qi * k + r] = heap[r].first;
+                OI[qi * k + r] = heap[r].second;
+            }
+        }
+    });
+
+    return {out_dists, out_ids};
+}
+
+std::pair<torch::Tensor, torch::Tensor> exact_knn(const torch::Tensor &data, const torch::Tensor &queries, int k)
+{
+    torch::NoGradGuard no_grad;
+    if (k < 1)
+    {
+        throw std::invalid_argument("exact_knn: k must be at least 1");
+    }
+    if (data.dim() != 2 || queries.dim() != 2 || queries.size(1) != data.size(1))
+    {
+        throw std::invalid_argument("exact_knn: data and queries must be [N, D] and [Q, D]");
+    }
+    auto x = data.to(torch::kCPU, torch::kFloat);
+    auto q = queries.to(torch::kCPU, torch::kFloat);
+    auto kk = std::min<int64_t>(k, x.size(0));
+
+    // Columns past N keep the +inf / -1 padding
+    auto out_dists = torch::full({q.size(0), k}, std::numeric_limits<float>::infinity(), torch::kFloat);
+    auto out_ids = torch::full({q.size(0), k}, -1, torch::kLong);
+    if (kk == 0)
+        return {out_dists, out_ids};
+
+    // Blocks of queries keep the [block, N] distance matrix bounded
+    const int64_t block = 256;
+    for (int64_t begin = 0; begin < q.size(0); begin += block)
+    {
+        auto end = std::min(q.size(0), begin + block);
+        auto d = torch::cdist(q.slice(0, begin, end), x).square();
+        auto [bd, bi] = d.topk(kk, 1, /*largest=*/false);
+        out_dists.slice(0, begin, end).slice(1, 0, kk).copy_(bd);
+        out_ids.slice(0, begin, end).slice(1, 0, kk).copy_(bi);
+    }
+    return {out_dists, out_ids};
+}
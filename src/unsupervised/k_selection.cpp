@@ -0,0 +1,201 @@
+#include "unsupervised/k_selection.hpp"
+#include "unsupervised/kmeans.hpp"
+#include <ATen/CPUGeneratorImpl.h>
+#include <algorithm>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+    // torch::multinomial accepts at most 2^24 categories
+    constexpr int64_t max_seed_candidates = 1 << 24;
+
+    // Adds K − current centroids, each drawn with probability proportional to the squared
+    // distance to the nearest existing centroid (k-means++ seeding, one batch per K).
+    torch::Tensor grow_centroids(const torch::Tensor &points, const torch::Tensor &centroids, int K,
+                                 at::Generator &generator)
+    {
+        int extra = K - (int)centroids.size(0);
+        if (extra <= 0)
+            return centroids;
+
+        // 'points' is already a random permutation of the data, so a prefix is a random subset
+        auto candidates = points.slice(0, 0, std::min(points.size(0), max_seed_candidates));
+        auto weights = torch::cdist(candidates, centroids).square().amin(1).to(torch::kCPU, torch::kDouble);
+
+        // Sampling without replacement needs 'extra' non-zero weights. Candidates on top of a
+        // centroid weigh nothing, so with too few others take all of those and top up
+        // uniformly from the rest.
+        auto positive = weights > 0;
+        int64_t n_positive = positive.sum().item<int64_t>();
+        torch::Tensor picks;
+        if (n_positive >= extra)
+        {
+            picks = torch::multinomial(weights, extra, /*replacement=*/false, generator);
+        }
+        else
+        {
+            auto top_up = torch::multinomial(positive.logical_not().to(torch::kDouble), extra - n_positive,
+                                             /*replacement=*/false, generator);
+            picks = torch::cat({positive.nonzero().squeeze(1), top_up});
+        }
+        picks = picks.to(points.device());
+        return torch::cat({centroids, candidates.index_select(0, picks)}, 0);
+    }
+
+    // Knee of a decreasing inertia curve: the point furthest below the chord joining its ends.
+    int elbow(const std::vector<k_score> &scores)
+    {
+        if (scores.size() < 3)
+            return scores.front().K;
+
+        const auto &first = scores.front();
+        const auto &last = scores.back();
+        double y_span = first.inertia - last.inertia;
+        if (y_span <= 0)
+            return first.K;
+
+        int best_k = first.K;
+        double best_gap = 0;
+        for (const auto &s : scores)
+        {
+            double x = (double)(s.K - first.K) / (last.K - first.K);
+            double y = (s.inertia - last.inertia) / y_span;
+            double gap = (1.0 - x) - y; // chord runs from (0, 1) to (1, 0)
+            if (gap > best_gap)
+            {
+                best_gap = gap;
+                best_k = s.K;
+            }
+        }
+        return best_k;
+    }
+}
+
+double sampled_silhouette(const torch::Tensor &points, const torch::Tensor &labels, int K, int64_t sample_size,
+                          uint64_t seed)
+{
+    torch::NoGradGuard no_grad;
+    const float inf = std::numeric_limits<float>::infinity();
+
+    auto generator = at::make_generator<at::CPUGeneratorImpl>(seed);
+    auto n = points.size(0);
+    auto m = std::min(n, sample_size);
+    auto idx = torch::randperm(n, generator, torch::kLong).slice(0, 0, m).to(points.device());
+    auto xs = points.index_select(0, idx);
+    auto ls = labels.index_select(0, idx);
+
+    // Sum of distances from every sampled point to each cluster, in one index_add_
+    auto d = torch::cdist(xs, xs);
+    auto sums = torch::zeros({m, K}, d.options()).index_add_(1, ls, d);
+    auto counts = torch::zeros({K}, d.options()).index_add_(0, ls, torch::ones({m}, d.options()));
+
+    // a(i): mean distance to the rest of its own cluster
+    auto own = ls.unsqueeze(1);
+    auto own_count = counts.index_select(0, ls);
+    auto a = sums.gather(1, own).squeeze(1) / (own_count - 1).clamp_min(1);
+
+    // b(i): smallest mean distance to another non-empty cluster
+    auto mean_other = sums / counts.clamp_min(1).unsqueeze(0);
+    mean_other.scatter_(1, own, inf);
+    mean_other.masked_fill_(counts.eq(0).unsqueeze(0), inf);
+    auto b = std::get<0>(mean_other.min(1));
+
+    auto s = (b - a) / torch::max(a, b).clamp_min(1e-12);
+    // Singletons and single-cluster samples score 0 by convention
+    s.masked_fill_(own_count.le(1), 0);
+    s.masked_fill_(torch::isinf(b), 0);
+    return s.mean().item<double>();
+}
+
+k_selection_result select_k(const torch::Tensor &projected, const k_selection_options &options)
+{
+    if (options.k_min < 2 || options.k_max < options.k_min || options.k_step < 1)
+    {
+        throw std::invalid_argument("select_k needs 2 <= k_min <= k_max and k_step >= 1");
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto generator = at::make_generator<at::CPUGeneratorImpl>(options.seed);
+    auto device = projected.device();
+
+    // 1. Fit every K on the same random sample
+    auto n = projected.size(0);
+    auto perm = torch::randperm(n, generator, torch::kLong).to(device);
+    auto fit_rows = options.fit_sample > 0 ? std::min(n, options.fit_sample) : n;
+    auto fit = projected.index_select(0, perm.slice(0, 0, fit_rows));
+    if (options.k_max > fit_rows)
+    {
+        throw std::invalid_argument("select_k: k_max is larger than the number of fitted rows");
+    }
+
+    if (options.verbose)
+    {
+        std::cout << "=== K selection over [" << options.k_min << ", " << options.k_max << "] on " << fit_rows
+                  << " rows ===\n\n";
+    }
+
+    k_selection_result result;
+    std::vector<std::future<double>> silhouettes;
+    auto centroids = fit.slice(0, 0, 1).clone();
+
+    for (int K = options.k_min; K <= options.k_max; K += options.k_step)
+    {
+        // 2. Respect the time budget, but always evaluate at least one K
+        if (!result.scores.empty() && std::chrono::steady_clock::now() - start > options.time_budget)
+        {
+            result.budget_exhausted = true;
+            break;
+        }
+
+        // 3. Warm start from the previous K
+        kmeans_options km(K);
+        km.max_iters = options.max_iters;
+        km.tol = options.tol;
+        km.init_centroids = grow_centroids(fit, centroids, K, generator);
+        auto run = kmeans_fit(fit, km);
+        centroids = run.centroids;
+
+        k_score score;
+        score.K = K;
+        score.inertia = run.inertia / fit_rows;
+        score.iterations = run.iterations;
+        result.scores.push_back(score);
+
+        // 4. Silhouette of this K overlaps with fitting the next one
+        silhouettes.push_back(std::async(std::launch::async, sampled_silhouette, fit, run.labels, K,
+                                         options.silhouette_sample, options.seed + (uint64_t)K));
+    }
+
+    for (size_t i = 0; i < silhouettes.size(); ++i)
+    {
+        result.scores[i].silhouette = silhouettes[i].get();
+    }
+
+    // 5. Recommend
+    const k_score *best = &result.scores.front();
+    for (const auto &s : result.scores)
+    {
+        if (s.silhouette > best->silhouette)
+            best = &s;
+    }
+    result.best_silhouette_k = best->K;
+    result.elbow_k = elbow(result.scores);
+    result.recommended_k = best->silhouette > 0 ? result.best_silhouette_k : result.elbow_k;
+
+    if (options.verbose)
+    {
+        for (const auto &s : result.scores)
+        {
+            std::cout << "  K=" << s.K << "  inertia = " << s.inertia << "  silhouette = " << s.silhouette
+                      << "  iterations = " << s.iterations << "\n";
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "\nBest silhouette K = " << result.best_silhouette_k << ", elbow K = " << result.elbow_k
+                  << " → recommending K = " << result.recommended_k << " (" << elapsed << " s"
+                  << (result.budget_exhausted ? ", time budget reached" : "") << ")\n\n";
+    }
+    return result;
+}
@@ -0,0 +1,252 @@
+#include "unsupervised/kmeans.hpp"
+#include "trace/trace.hpp"
+#include <ATen/CPUGeneratorImpl.h>
+#include <ATen/Parallel.h>
+#include <algorithm>
+#include <atomic>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    // Reduction over dim 1, as an IntArrayRef that needs no allocation
+    const int64_t row_dims[] = {1};
+
+    void check_k(int64_t n, int K)
+    {
+        if (K < 1 || K > n)
+        {
+            throw std::invalid_argument("k-means needs 1 <= K <= number of points (K = " + std::to_string(K) +
+                                        ", n = " + std::to_string(n) + ")");
+        }
+    }
+}
+
+void kmeans_assign(const torch::Tensor &points, const torch::Tensor &x_sq, const torch::Tensor &centroids,
+                   torch::Tensor &dists, torch::Tensor &min_dists, torch::Tensor &labels, torch::Tensor *c_sq)
+{
+    // ‖c‖² broadcast over the rows, then -2·x·cᵀ accumulated on top by one GEMM
+    torch::Tensor c_sq_local = c_sq ? *c_sq : torch::empty({centroids.size(0)}, centroids.options());
+    torch::linalg_vector_norm_out(c_sq_local, centroids, 2, torch::IntArrayRef(row_dims)).square_();
+    torch::addmm_out(dists, c_sq_local.unsqueeze(0), points, centroids.t(), /*beta=*/1, /*alpha=*/-2);
+
+    // ‖x‖² is constant per row so it does not change the argmin; add it afterwards
+    // to turn the minimum into the true squared distance (clamped against round-off).
+    torch::min_out(min_dists, labels, dists, 1);
+    min_dists.add_(x_sq).clamp_min_(0);
+}
+
+void kmeans_update(const torch::Tensor &points, const torch::Tensor &labels, const torch::Tensor &centroids,
+                   const torch::Tensor &ones, torch::Tensor &sums, torch::Tensor &counts,
+                   torch::Tensor &new_centroids, torch::Tensor *non_empty)
+{
+    sums.zero_().index_add_(0, labels, points);
+    counts.zero_().index_add_(0, labels, ones);
+
+    torch::Tensor mask = non_empty ? *non_empty : torch::empty({counts.size(0)}, counts.options().dtype(torch::kBool));
+    torch::gt_out(mask, counts, 0);
+    counts.clamp_min_(1);
+    torch::div_out(new_centroids, sums, counts.unsqueeze(1));
+    torch::where_out(new_centroids, mask.unsqueeze(1), new_centroids, centroids);
+}
+
+namespace
+{
+    // Workspace slots of one Lloyd run
+    enum lloyd_slot
+    {
+        slot_x_sq,
+        slot_dists,
+        slot_min_dists,
+        slot_labels,
+        slot_ones,
+        slot_sums,
+        slot_counts,
+        slot_centroids,
+        slot_new_centroids,
+        slot_c_sq,
+        slot_non_empty,
+        slot_shift
+    };
+
+    // One Lloyd run. Starts from 'init' when defined, otherwise K random rows drawn with
+    // 'generator' (or the global torch RNG when it is empty).
+    // Buffers come from 'shared' when given, and the results are then copied out of it;
+    // otherwise from a private workspace that the results keep alive.
+    kmeans_result lloyd(const torch::Tensor &projected, int K, int max_iters, float tol,
+                        std::optional<at::Generator> generator, const torch::Tensor &init, bool verbose,
+                        workspace *shared)
+    {
+        trace_span span("kmeans.run", "kmeans");
+        workspace local;
+        workspace &ws = shared ? *shared : local;
+
+        // 1. Get the device of the input data
+        auto device = projected.device();
+        // Helper to create options for indices (must be Long/Int64)
+        auto index_options = torch::TensorOptions().device(device).dtype(torch::kLong);
+        auto options = projected.options();
+
+        // 2. Initialize Centroids
+        auto n = projected.size(0), d = projected.size(1);
+        auto centroids = ws.get(slot_centroids, {K, d}, options);
+        if (init.defined())
+        {
+            centroids.copy_(init);
+        }
+        else
+        {
+            torch::Tensor perm;
+            if (generator)
+            {
+                // Per-run generators are CPU generators, so draw the permutation there
+                perm = torch::randperm(n, *generator, torch::kLong).to(device);
+            }
+            else
+            {
+                // Create 'perm' directly on the correct device
+                perm = torch::randperm(n, index_options);
+            }
+            torch::index_select_out(centroids, projected, 0, perm.slice(0, 0, K));
+        }
+
+        // 3. Workspaces: every iteration below runs on these buffers only
+        auto x_sq = ws.get(slot_x_sq, {n}, options);
+        torch::linalg_vector_norm_out(x_sq, projected, 2, torch::IntArrayRef(row_dims)).square_();
+        auto dists = ws.get(slot_dists, {n, K}, options);
+        auto min_dists = ws.get(slot_min_dists, {n}, options);
+        auto labels = ws.get(slot_labels, {n}, index_options);
+        auto ones = ws.get(slot_ones, {n}, options).fill_(1);
+        auto sums = ws.get(slot_sums, {K, d}, options);
+        auto counts = ws.get(slot_counts, {K}, options);
+        auto new_centroids = ws.get(slot_new_centroids, {K, d}, options);
+        auto c_sq = ws.get(slot_c_sq, {K}, options);
+        auto non_empty = ws.get(slot_non_empty, {K}, options.dtype(torch::kBool));
+        auto shift = ws.get(slot_shift, {}, options);
+
+        int iter;
+        for (iter = 0; iter < max_iters; ++iter)
+        {
+            // 4. Assign Labels
+            {
+                trace_span step("kmeans.assign", "kmeans");
+                kmeans_assign(projected, x_sq, centroids, dists, min_dists, labels, &c_sq);
+            }
+
+            // 5. Update Centroids
+            {
+                trace_span step("kmeans.update", "kmeans");
+                kmeans_update(projected, labels, centroids, ones, sums, counts, new_centroids, &non_empty);
+            }
+
+            // 6. Check for Convergence
+            // 'sums' is free until the next update, so it holds the centroid shift
+            torch::sub_out(sums, new_centroids, centroids);
+            float shift_val = torch::linalg_vector_norm_out(shift, sums, 2).item<float>();
+            std::swap(centroids, new_centroids);
+
+            if (verbose && (iter % 20 == 0 || iter == max_iters - 1))
+            {
+                std::cout << "Iter " << iter << "  shift = " << shift_val << "\n";
+            }
+
+            if (shift_val < tol)
+                break;
+        }
+
+        // 7. Final assignment so labels and inertia refer to the returned centroids
+        kmeans_assign(projected, x_sq, centroids, dists, min_dists, labels, &c_sq);
+
+        kmeans_result result;
+        result.labels = shared ? labels.clone() : labels;
+        result.centroids = shared ? centroids.clone() : centroids;
+        result.inertia = min_dists.sum().item<double>();
+        result.iterations = iter;
+        return result;
+    }
+}
+
+torch::Tensor kmeans(torch::Tensor projected, int n_samples, int K, int max_iters, float tol, bool verbose,
+                     workspace *ws)
+{
+    trace_span span("kmeans", "kmeans");
+    if (verbose)
+        std::cout << "=== K-Means in PCA-reduced space ===\n\n";
+
+    auto points = projected.slice(0, 0, n_samples);
+    check_k(points.size(0), K);
+    auto result = lloyd(points, K, max_iters, tol, std::nullopt, torch::Tensor(), verbose, ws);
+
+    if (verbose)
+        std::cout << "\nConverged after " << result.iterations << " iterations.\n";
+    return result.labels;
+}
+
+kmeans_result kmeans_fit(const torch::Tensor &projected, const kmeans_options &options)
+{
+    trace_span span("kmeans_fit", "kmeans");
+    if (options.verbose)
+        std::cout << "=== K-Means in PCA-reduced space (" << options.n_init << " restarts) ===\n\n";
+
+    check_k(projected.size(0), options.K);
+
+    const int n_init = options.init_centroids.defined() ? 1 : std::max(1, options.n_init);
+    // The caller's intra-op budget bounds everything below; the global setting is never changed
+    const int budget = std::max(1, at::get_num_threads());
+    int n_threads = options.n_threads > 0 ? options.n_threads : (n_init >= budget ? budget : 1);
+    n_threads = std::max(1, std::min({n_threads, n_init, budget}));
+
+    // Run r always uses seed + r, whichever worker picks it up, so the winner only
+    // depends on the seed. Ties go to the lowest run index.
+    std::vector<kmeans_result> runs(n_init);
+    std::atomic<int> next_run{0};
+
+    auto worker = [&]() {
+        workspace ws;
+        for (int r = next_run++; r < n_init; r = next_run++)
+        {
+            auto generator = at::make_generator<at::CPUGeneratorImpl>(options.seed + (uint64_t)r);
+            runs[r] = lloyd(projected, options.K, options.max_iters, options.tol, generator,
+                            options.init_centroids, false, &ws);
+        }
+    };
+
+    if (n_threads == 1)
+    {
+        // One restart after another, each with the whole budget
+        worker();
+    }
+    else
+    {
+        // One worker per intra-op pool thread; ATen runs the ops nested in a parallel
+        // region single-threaded, so the restarts never oversubscribe the budget. The
+        // first exception of a worker is rethrown here.
+        at::parallel_for(0, n_threads, 1, [&](int64_t begin, int64_t end) {
+            for (int64_t t = begin; t < end; ++t)
+                worker();
+        });
+    }
+
+    int best = 0;
+    for (int r = 0; r < n_init; ++r)
+    {
+        if (options.verbose)
+        {
+            std::cout << "Run " << r << "  inertia = " << runs[r].inertia
+                      << "  iterations = " << runs[r].iterations << "\n";
+        }
+        if (runs[r].inertia < runs[best].inertia)
+            best = r;
+    }
+
+    if (options.verbose)
+        std::cout << "\nBest run: " << best << " (inertia " << runs[best].inertia << ")\n";
+
+    kmeans_result result = runs[best];
+    result.best_run = best;
+    return result;
+}
@@ -0,0 +1,14 @@
+#include "unsupervised/measurement_tensors.hpp"
+
+torch::Tensor validity_mask(const validity_bitmap &validity)
+{
+    const int64_t n = (int64_t)validity.size();
+    if (n == 0)
+        return torch::zeros({0}, torch::kBool);
+
+    // Shift every 64-bit word by 0..63 and keep the low bit: [words, 64] → [N]
+    const int64_t n_words = (n + 63) / 64;
+    auto words = torch::from_blob(const_cast<uint64_t *>(validity.data()), {n_words, 1}, torch::kLong);
+    auto shifts = torch::arange(64, torch::kLong).unsqueeze(0);
+    return words.bitwise_right_shift(shifts).bitwise_and_(1).view({-1}).slice(0, 0, n).to(torch::kBool);
+}
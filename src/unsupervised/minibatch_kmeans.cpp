@@ -0,0 +1,79 @@
+#include "unsupervised/minibatch_kmeans.hpp"
+#include "unsupervised/kmeans.hpp"
+#include <stdexcept>
+
+void minibatch_kmeans::init_centroids(const torch::Tensor &batch)
+{
+    if (batch.size(0) < K)
+    {
+        throw std::invalid_argument("First mini-batch needs at least K rows to seed the centroids");
+    }
+
+    auto index_options = torch::TensorOptions().device(batch.device()).dtype(torch::kLong);
+    auto perm = torch::randperm(batch.size(0), index_options);
+    centroids_ = batch.index_select(0, perm.slice(0, 0, K)).clone();
+    counts_ = torch::zeros({K}, batch.options());
+    sums = torch::empty_like(centroids_);
+    batch_counts = torch::empty({K}, batch.options());
+}
+
+void minibatch_kmeans::partial_fit(const torch::Tensor &input)
+{
+    if (!initialized())
+        init_centroids(input);
+
+    auto batch = input.to(centroids_.options());
+    auto n = batch.size(0);
+
+    // Only reallocate when the batch size changes (usually just the last batch)
+    if (!dists.defined() || dists.size(0) != n)
+    {
+        dists = torch::empty({n, K}, batch.options());
+        min_dists = torch::empty({n}, batch.options());
+        labels = torch::empty({n}, batch.options().dtype(torch::kLong));
+        ones = torch::ones({n}, batch.options());
+    }
+    x_sq = batch.square().sum(1);
+
+    kmeans_assign(batch, x_sq, centroids_, dists, min_dists, labels);
+    last_inertia = min_dists.sum().item<double>();
+
+    sums.zero_().index_add_(0, labels, batch);
+    batch_counts.zero_().index_add_(0, labels, ones);
+
+    // Per-centroid learning rate: c ← c + (Σx − n_b·c) / n_total.
+    // Centroids that received no points in this batch do not move.
+    counts_.add_(batch_counts);
+    sums.sub_(centroids_ * batch_counts.unsqueeze(1));
+    centroids_.add_(sums / counts_.clamp_min(1).unsqueeze(1));
+}
+
+void minibatch_kmeans::fit(batch_source &source, int epochs)
+{
+    for (int epoch = 0; epoch < epochs; ++epoch)
+    {
+        if (epoch > 0)
+            source.reset();
+
+        for (auto batch = source.next(); batch.defined(); batch = source.next())
+        {
+            partial_fit(batch);
+        }
+    }
+}
+
+torch::Tensor minibatch_kmeans::predict(const torch::Tensor &points) const
+{
+    if (!initialized())
+    {
+        throw std::runtime_error("minibatch_kmeans::predict called before any partial_fit");
+    }
+
+    auto pts = points.to(centroids_.options());
+    auto n = pts.size(0);
+    auto d = torch::empty({n, K}, pts.options());
+    auto md = torch::empty({n}, pts.options());
+    auto lb = torch::empty({n}, pts.options().dtype(torch::kLong));
+    kmeans_assign(pts, pts.square().sum(1), centroids_, d, md, lb);
+    return lb;
+}
@@ -0,0 +1,37 @@
+#include "unsupervised/ocid_dataset.hpp"
+#include "unsupervised/snapshot.hpp"
+#include <stdexcept>
+
+ocid_dataset::ocid_dataset(torch::Tensor features, torch::Tensor targets)
+    : features(features.contiguous()), targets(targets.defined() ? targets.contiguous() : targets)
+{
+    if (this->features.dim() != 2)
+    {
+        throw std::invalid_argument("ocid_dataset features must be [rows, features]");
+    }
+    if (this->targets.defined() && this->targets.size(0) != this->features.size(0))
+    {
+        throw std::invalid_argument("ocid_dataset needs one target per feature row");
+    }
+}
+
+ocid_dataset ocid_dataset::from_snapshot(const std::string &path, bool mmap)
+{
+    return ocid_dataset(mmap ? map_snapshot(path) : load_snapshot(path));
+}
+
+torch::data::Example<> ocid_dataset::get_batch(std::vector<size_t> indices)
+{
+    static_assert(sizeof(size_t) == sizeof(int64_t), "indices are reinterpreted as int64");
+
+    // Borrow the sampler's index buffer; index_select copies, so nothing outlives it
+    auto index = torch::from_blob(indices.data(), {(int64_t)indices.size()}, torch::kLong);
+    auto data = features.index_select(0, index);
+    auto target = targets.defined() ? targets.index_select(0, index) : torch::Tensor();
+    return {data, target};
+}
+
+torch::optional<size_t> ocid_dataset::size() const
+{
+    return (size_t)features.size(0);
+}
@@ -0,0 +1,115 @@
+#include "unsupervised/simulator.hpp"
+#include "unsupervised/snapshot.hpp"
+#include "internal/hash.hpp"
+#include <ATen/CPUGeneratorImpl.h>
+#include <ATen/Parallel.h>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    int64_t chunk_count(int64_t n_samples, int64_t chunk_rows)
+    {
+        return (n_samples + chunk_rows - 1) / chunk_rows;
+    }
+
+    void check_arguments(int64_t n_samples, const simulator_options &options)
+    {
+        if (n_samples < 0)
+            throw std::invalid_argument("simulator: n_samples must not be negative");
+        if (options.chunk_rows < 1)
+            throw std::invalid_argument("simulator: chunk_rows must be at least 1");
+    }
+}
+
+void simulate_chunk(torch::Tensor out, int64_t chunk_index, uint64_t seed)
+{
+    torch::NoGradGuard no_grad;
+    // Decorrelates neighbouring (seed, chunk) pairs
+    const uint64_t chunk_seed = internal::mix_step(seed ^ internal::mix_step((uint64_t)chunk_index));
+    auto generator = at::make_generator<at::CPUGeneratorImpl>(chunk_seed);
+    const int64_t rows = out.size(0);
+
+    // Base "true" location influence (simplified: stronger signal closer to "origin")
+    auto dist_factor = torch::empty({rows}, torch::kFloat).uniform_(0.2, 1.0, generator); // 0.2–1.0 distance factor
+
+    // Correlated signal strengths (stronger near "home" cell, weaker far away):
+    // 8 visible sectors × 3 bands, decay + noise, written straight into 'out'
+    for (int i = 0; i < 8; ++i)
+    {
+        float base = -55.0 - i * 8.0; // closer cells stronger
+        auto group = out.slice(1, i * 3, i * 3 + 3);
+        group.normal_(0.0, 4.0, generator);
+        group.add_((base * torch::pow(dist_factor, 1.5 + i * 0.3)).unsqueeze(1));
+    }
+
+    // Timing advance columns (roughly increase with distance)
+    for (int i = 0; i < 8; ++i)
+    {
+        auto ta = out.slice(1, 24 + i, 25 + i);
+        ta.normal_(0.0, 0.4, generator);
+        ta.add_(dist_factor.unsqueeze(1) * (3.0f + i * 0.5f) + 0.1f);
+    }
+}
+
+torch::Tensor simulate_fingerprints(int64_t n_samples, const simulator_options &options)
+{
+    check_arguments(n_samples, options);
+    auto out = torch::empty({n_samples, simulator_features}, torch::kFloat);
+    const int64_t chunk_rows = options.chunk_rows;
+
+    // One chunk per task; torch ops inside a parallel region run single-threaded
+    at::parallel_for(0, chunk_count(n_samples, chunk_rows), 1, [&](int64_t begin, int64_t end) {
+        for (int64_t c = begin; c < end; ++c)
+        {
+            auto rows = out.slice(0, c * chunk_rows, std::min(n_samples, (c + 1) * chunk_rows));
+            simulate_chunk(rows, c, options.seed);
+        }
+    });
+    return out;
+}
+
+void simulate_to_snapshot(const std::string &path, int64_t n_samples, const simulator_options &options)
+{
+    check_arguments(n_samples, options);
+    const int64_t chunk_rows = options.chunk_rows;
+    const int64_t n_chunks = chunk_count(n_samples, chunk_rows);
+    const int64_t wave = std::max<int64_t>(1, at::get_num_threads());
+
+    // One buffer per concurrently generated chunk, reused for every wave
+    auto buffer = torch::empty({wave * chunk_rows, simulator_features}, torch::kFloat);
+    snapshot_writer writer(path, n_samples, simulator_features, options.seed);
+
+    for (int64_t first = 0; first < n_chunks; first += wave)
+    {
+        int64_t last = std::min(n_chunks, first + wave);
+        at::parallel_for(first, last, 1, [&](int64_t begin, int64_t end) {
+            for (int64_t c = begin; c < end; ++c)
+            {
+                int64_t rows = std::min(n_samples, (c + 1) * chunk_rows) - c * chunk_rows;
+                auto slot = buffer.slice(0, (c - first) * chunk_rows, (c - first) * chunk_rows + rows);
+                simulate_chunk(slot, c, options.seed);
+            }
+        });
+
+        // Chunks of a wave are adjacent, so they go out in a single write
+        int64_t rows = std::min(n_samples, last * chunk_rows) - first * chunk_rows;
+        writer.append(buffer.slice(0, 0, rows));
+    }
+    writer.close();
+}
+
+void simulate_to_tensor_file(const std::string &path, int64_t n_samples, const simulator_options &options)
+{
+    torch::save(simulate_fingerprints(n_samples, options), path);
+}
+
+torch::Tensor sampleSimulator(int n_samples, int n_features)
+{
+    // Draw the dataset seed from the global RNG so torch::manual_seed still controls the output
+    simulator_options options;
+    options.seed = (uint64_t)torch::randint(std::numeric_limits<int64_t>::max(), {1}, torch::kLong).item<int64_t>();
+    return simulate_fingerprints(n_samples, options); // final fingerprint matrix [n_samples × 32]
+}
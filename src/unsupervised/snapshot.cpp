@@ -0,0 +1,117 @@
+#include "unsupervised/snapshot.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool snapshot_header::valid() const
+{
+    return std::memcmp(magic, snapshot_header().magic, sizeof(magic)) == 0 && rows >= 0 && cols > 0;
+}
+
+snapshot_writer::snapshot_writer(const std::string &path, int64_t rows, int64_t cols, uint64_t seed)
+    : file(path, std::ios::binary | std::ios::trunc), written(0)
+{
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Could not create snapshot at: " + path);
+    }
+    header.rows = rows;
+    header.cols = cols;
+    header.seed = seed;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+void snapshot_writer::append(const torch::Tensor &chunk)
+{
+    if (chunk.dim() != 2 || chunk.size(1) != header.cols)
+    {
+        throw std::invalid_argument("Snapshot chunk must be [rows, " + std::to_string(header.cols) + "]");
+    }
+    if (written + chunk.size(0) > header.rows)
+    {
+        throw std::out_of_range("Snapshot chunk writes past the declared row count");
+    }
+
+    auto data = chunk.to(torch::kCPU, torch::kFloat).contiguous();
+    file.write(reinterpret_cast<const char *>(data.data_ptr<float>()), data.numel() * sizeof(float));
+    if (!file)
+    {
+        throw std::runtime_error("Failed writing snapshot chunk");
+    }
+    written += chunk.size(0);
+}
+
+void snapshot_writer::close()
+{
+    if (written != header.rows)
+    {
+        throw std::runtime_error("Snapshot closed after " + std::to_string(written) + " of " +
+                                 std::to_string(header.rows) + " rows");
+    }
+    file.close();
+}
+
+snapshot_header read_snapshot_header(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Could not open snapshot at: " + path);
+    }
+    snapshot_header header;
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!file || !header.valid())
+    {
+        throw std::runtime_error("Not a fingerprint snapshot: " + path);
+    }
+    return header;
+}
+
+torch::Tensor load_snapshot(const std::string &path)
+{
+    auto header = read_snapshot_header(path);
+    std::ifstream file(path, std::ios::binary);
+    file.seekg(sizeof(snapshot_header));
+
+    auto data = torch::empty({header.rows, header.cols}, torch::kFloat);
+    file.read(reinterpret_cast<char *>(data.data_ptr<float>()), data.numel() * sizeof(float));
+    if (!file)
+    {
+        throw std::runtime_error("Snapshot is truncated: " + path);
+    }
+    return data;
+}
+
+torch::Tensor map_snapshot(const std::string &path)
+{
+    auto header = read_snapshot_header(path);
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Could not open snapshot at: " + path);
+    }
+
+    struct stat st;
+    const size_t length = sizeof(snapshot_header) + (size_t)(header.rows * header.cols) * sizeof(float);
+    if (::fstat(fd, &st) != 0 || (size_t)st.st_size < length)
+    {
+        ::close(fd);
+        throw std::runtime_error("Snapshot is truncated: " + path);
+    }
+
+    // The mapping outlives the descriptor
+    void *base = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED)
+    {
+        throw std::runtime_error("Could not map snapshot: " + path);
+    }
+
+    // The 32-byte header keeps the float data aligned
+    auto data = static_cast<char *>(base) + sizeof(snapshot_header);
+    return torch::from_blob(
+        data, {header.rows, header.cols}, [base, length](void *) { ::munmap(base, length); }, torch::kFloat);
+}
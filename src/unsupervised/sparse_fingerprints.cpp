@@ -0,0 +1,274 @@
+#include "unsupervised/sparse_fingerprints.hpp"
+#include "internal/hash.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+
+using internal::mix;
+
+namespace
+{
+    // Sort keys for the row and column dictionaries
+    using bucket_key = std::pair<int64_t, int64_t>;
+    using cell_key = std::tuple<int32_t, int32_t, int32_t, int64_t>;
+
+    template <typename K>
+    int64_t index_of(const std::vector<K> &sorted, const K &k)
+    {
+        return std::lower_bound(sorted.begin(), sorted.end(), k) - sorted.begin();
+    }
+
+}
+
+struct sparse_fingerprint_builder::record {
+    bool has_location, has_signal, has_ta;
+    double lat, lon;
+    int32_t mcc, mnc, lac, signal, ta;
+    int64_t cellid;
+
+    // Zero means absent in measurement
+    explicit record(const measurement &m)
+        : has_location(m.core_data.lat != 0 || m.core_data.lon != 0), has_signal(m.movement_data.signal != 0),
+          has_ta(m.tech.ta != 0), lat(m.core_data.lat), lon(m.core_data.lon), mcc(m.key.mcc), mnc(m.key.mnc),
+          lac(m.key.lac), signal(m.movement_data.signal), ta(m.tech.ta), cellid(m.key.cellid) {}
+
+    record(const measurement_batch &b, size_t i)
+        : has_location(b.lat.valid(i) || b.lon.valid(i)), has_signal(b.signal.valid(i)), has_ta(b.ta.valid(i)),
+          lat(b.lat.values[i]), lon(b.lon.values[i]), mcc(b.mcc[i]), mnc(b.mnc[i]), lac(b.lac[i]),
+          signal(b.signal.values[i]), ta(b.ta.values[i]), cellid(b.cellid[i]) {}
+};
+
+namespace
+{
+    template <typename Aggregate, typename Record>
+    void accumulate(Aggregate &a, const Record &r)
+    {
+        ++a.samples;
+        if (r.has_signal)
+        {
+            a.signal_sum += r.signal;
+            ++a.signal_count;
+        }
+        if (r.has_ta)
+        {
+            a.ta_sum += r.ta;
+            ++a.ta_count;
+        }
+    }
+
+    // Record is the builder's private record type
+    template <typename Record>
+    Record record_at(const std::vector<measurement> &rows, size_t i)
+    {
+        return Record(rows[i]);
+    }
+
+    template <typename Record>
+    Record record_at(const measurement_batch &batch, size_t i)
+    {
+        return Record(batch, i);
+    }
+}
+
+size_t sparse_fingerprint_builder::pair_hash::operator()(const pair_key &k) const
+{
+    uint64_t h = mix((uint64_t)k.lat_row * 0x9E3779B97F4A7C15ULL ^ (uint64_t)k.lon_col);
+    h = mix(h ^ (uint64_t)k.cellid);
+    h = mix(h ^ ((uint64_t)(uint32_t)k.lac << 32 | (uint32_t)k.mnc) ^ ((uint64_t)(uint32_t)k.mcc << 16));
+    return (size_t)h;
+}
+
+void sparse_fingerprint_builder::aggregate::merge(const aggregate &o)
+{
+    signal_sum += o.signal_sum;
+    ta_sum += o.ta_sum;
+    signal_count += o.signal_count;
+    ta_count += o.ta_count;
+    samples += o.samples;
+}
+
+sparse_fingerprint_builder::sparse_fingerprint_builder(sparse_fingerprint_options options)
+    : options(options), shards(std::max(1, options.n_shards))
+{
+    if (options.bucket_degrees <= 0 || options.bucket_degrees > 180)
+    {
+        throw std::invalid_argument("sparse_fingerprint_builder bucket size must be in (0, 180] degrees");
+    }
+}
+
+bool sparse_fingerprint_builder::key_of(const record &r, pair_key &key) const
+{
+    if (!r.has_location)
+        return false;
+
+    key.lat_row = (int64_t)std::floor(r.lat / options.bucket_degrees);
+    key.lon_col = (int64_t)std::floor(r.lon / options.bucket_degrees);
+    key.mcc = r.mcc;
+    key.mnc = r.mnc;
+    key.lac = r.lac;
+    key.cellid = r.cellid;
+    return true;
+}
+
+size_t sparse_fingerprint_builder::shard_of(const pair_key &key) const
+{
+    // The high bits, so the shard choice stays independent of the map's bucket index
+    return (pair_hash()(key) >> 40) % shards.size();
+}
+
+void sparse_fingerprint_builder::add(const measurement &m)
+{
+    record r(m);
+    pair_key key;
+    if (!key_of(r, key))
+        return;
+
+    auto &s = shards[shard_of(key)];
+    std::lock_guard<std::mutex> guard(s.lock);
+    accumulate(s.pairs[key], r);
+}
+
+void sparse_fingerprint_builder::add(const std::vector<measurement> &batch)
+{
+    add_parallel(batch, batch.size());
+}
+
+void sparse_fingerprint_builder::add(const measurement_batch &batch)
+{
+    add_parallel(batch, batch.size());
+}
+
+template <typename Records>
+void sparse_fingerprint_builder::add_parallel(const Records &batch, size_t n)
+{
+    unsigned n_threads = options.n_threads;
+    if (n_threads == 0)
+        n_threads = std::max(1u, std::thread::hardware_concurrency());
+    n_threads = (unsigned)std::max<size_t>(1, std::min<size_t>(n_threads, n / 1024));
+
+    const size_t n_shards = shards.size();
+    const size_t chunk = (n + n_threads - 1) / n_threads;
+
+    // 1. Each thread aggregates its slice into private maps, already split by shard
+    std::vector<std::vector<pair_map>> local(n_threads, std::vector<pair_map>(n_shards));
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < n_threads; ++t)
+    {
+        pool.emplace_back([&, t]() {
+            size_t begin = std::min(n, t * chunk), end = std::min(n, begin + chunk);
+            pair_key key;
+            for (size_t i = begin; i < end; ++i)
+            {
+                auto r = record_at<record>(batch, i);
+                if (key_of(r, key))
+                    accumulate(local[t][shard_of(key)][key], r);
+            }
+        });
+    }
+    for (auto &th : pool)
+        th.join();
+    pool.clear();
+
+    // 2. Each thread owns a disjoint set of shards, so the merge takes every lock once
+    for (unsigned t = 0; t < n_threads; ++t)
+    {
+        pool.emplace_back([&, t]() {
+            for (size_t s = t; s < n_shards; s += n_threads)
+            {
+                std::lock_guard<std::mutex> guard(shards[s].lock);
+                for (auto &maps : local)
+                {
+                    for (const auto &entry : maps[s])
+                        shards[s].pairs[entry.first].merge(entry.second);
+                    pair_map().swap(maps[s]);
+                }
+            }
+        });
+    }
+    for (auto &th : pool)
+        th.join();
+}
+
+size_t sparse_fingerprint_builder::pairs() const
+{
+    size_t total = 0;
+    for (const auto &s : shards)
+    {
+        std::lock_guard<std::mutex> guard(s.lock);
+        total += s.pairs.size();
+    }
+    return total;
+}
+
+sparse_fingerprints sparse_fingerprint_builder::build(bool csr) const
+{
+    // 1. Snapshot every shard so the dictionaries and values agree
+    std::vector<std::pair<pair_key, aggregate>> entries;
+    entries.reserve(pairs());
+    for (const auto &s : shards)
+    {
+        std::lock_guard<std::mutex> guard(s.lock);
+        entries.insert(entries.end(), s.pairs.begin(), s.pairs.end());
+    }
+
+    // 2. Sorted, de-duplicated row and column dictionaries
+    std::vector<bucket_key> buckets;
+    std::vector<cell_key> cells;
+    buckets.reserve(entries.size());
+    cells.reserve(entries.size());
+    for (const auto &e : entries)
+    {
+        buckets.emplace_back(e.first.lat_row, e.first.lon_col);
+        cells.emplace_back(e.first.mcc, e.first.mnc, e.first.lac, e.first.cellid);
+    }
+    std::sort(buckets.begin(), buckets.end());
+    buckets.erase(std::unique(buckets.begin(), buckets.end()), buckets.end());
+    std::sort(cells.begin(), cells.end());
+    cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+
+    sparse_fingerprints out;
+    out.row_locations.resize(buckets.size());
+    for (size_t r = 0; r < buckets.size(); ++r)
+    {
+        out.row_locations[r].lat = buckets[r].first * options.bucket_degrees;
+        out.row_locations[r].lon = buckets[r].second * options.bucket_degrees;
+    }
+    out.col_cells.resize(cells.size());
+    for (size_t c = 0; c < cells.size(); ++c)
+    {
+        std::tie(out.col_cells[c].mcc, out.col_cells[c].mnc, out.col_cells[c].lac, out.col_cells[c].cellid) = cells[c];
+    }
+
+    // 3. COO triplets; every pair is unique, so coalesce() only sorts
+    const int64_t nnz = (int64_t)entries.size();
+    auto indices = torch::empty({2, nnz}, torch::kLong);
+    auto signal = torch::empty({nnz}, torch::kFloat);
+    auto ta = torch::empty({nnz}, torch::kFloat);
+    auto samples = torch::empty({nnz}, torch::kFloat);
+    auto idx = indices.accessor<int64_t, 2>();
+    auto sig = signal.accessor<float, 1>();
+    auto adv = ta.accessor<float, 1>();
+    auto cnt = samples.accessor<float, 1>();
+    for (int64_t i = 0; i < nnz; ++i)
+    {
+        const auto &k = entries[i].first;
+        const auto &a = entries[i].second;
+        idx[0][i] = index_of(buckets, bucket_key(k.lat_row, k.lon_col));
+        idx[1][i] = index_of(cells, cell_key(k.mcc, k.mnc, k.lac, k.cellid));
+        sig[i] = a.signal_count ? (float)(a.signal_sum / a.signal_count) : 0.0f;
+        adv[i] = a.ta_count ? (float)(a.ta_sum / a.ta_count) : 0.0f;
+        cnt[i] = (float)a.samples;
+    }
+
+    const std::vector<int64_t> size = {(int64_t)buckets.size(), (int64_t)cells.size()};
+    auto make = [&](const torch::Tensor &values) {
+        auto t = torch::sparse_coo_tensor(indices, values, size).coalesce();
+        return csr ? t.to_sparse_csr() : t;
+    };
+    out.signal = make(signal);
+    out.ta = make(ta);
+    out.samples = make(samples);
+    return out;
+}
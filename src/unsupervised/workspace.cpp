@@ -0,0 +1,93 @@
+#include "unsupervised/workspace.hpp"
+#include <c10/core/Allocator.h>
+#include <atomic>
+
+torch::Tensor workspace::get(size_t slot, torch::IntArrayRef sizes, const torch::TensorOptions &options)
+{
+    int64_t numel = 1;
+    for (auto s : sizes)
+        numel *= s;
+    const int64_t nbytes = numel * (int64_t)options.dtype().itemsize();
+
+    if (slot >= slots.size())
+        slots.resize(slot + 1);
+    auto &buffer = slots[slot];
+    if (!buffer.defined() || buffer.numel() < nbytes || buffer.device() != options.device())
+    {
+        buffer = torch::Tensor(); // free the old buffer before allocating its replacement
+        buffer = torch::empty({nbytes}, options.dtype(torch::kByte));
+        grown++;
+    }
+
+    // A zero-sized tensor allocates no storage; set_ points it at the slot's bytes
+    return torch::empty({0}, options).set_(buffer.storage(), 0, sizes);
+}
+
+int64_t workspace::bytes() const
+{
+    int64_t total = 0;
+    for (const auto &buffer : slots)
+    {
+        if (buffer.defined())
+            total += buffer.numel();
+    }
+    return total;
+}
+
+void workspace::release()
+{
+    slots.clear();
+}
+
+struct allocation_counter::reporter : public c10::MemoryReportingInfoBase {
+    std::atomic<int64_t> allocations{0}, frees{0}, bytes_allocated{0}, net{0}, peak{0};
+
+    void reportMemoryUsage(void *, int64_t alloc_size, size_t, size_t, c10::Device device) override
+    {
+        if (device.type() != c10::DeviceType::CPU)
+            return;
+        if (alloc_size > 0)
+        {
+            allocations++;
+            bytes_allocated += alloc_size;
+        }
+        else
+        {
+            frees++;
+        }
+        int64_t now = net += alloc_size;
+        int64_t seen = peak.load();
+        while (now > seen && !peak.compare_exchange_weak(seen, now))
+        {
+        }
+    }
+
+    bool memoryProfilingEnabled() const override { return true; }
+};
+
+allocation_counter::allocation_counter()
+    : state(std::make_shared<reporter>()),
+      guard(std::make_unique<c10::DebugInfoGuard>(c10::DebugInfoKind::PROFILER_STATE, state))
+{
+}
+
+allocation_counter::~allocation_counter() = default;
+
+allocation_stats allocation_counter::stats() const
+{
+    allocation_stats s;
+    s.allocations = state->allocations;
+    s.frees = state->frees;
+    s.bytes_allocated = state->bytes_allocated;
+    s.peak_bytes = state->peak;
+    return s;
+}
+
+void allocation_counter::reset()
+{
+    state->allocations = 0;
+    state->frees = 0;
+    state->bytes_allocated = 0;
+    state->net = 0;
+    state->peak = 0;
+}
@@ -0,0 +1,124 @@
+#include "unsupervised/zone_assigner.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+void save_zone_model(const std::string &path, const pca_model &model, const torch::Tensor &centroids)
+{
+    std::vector<torch::Tensor> tensors = {model.mean.cpu(), model.components.cpu(), centroids.cpu()};
+    torch::save(tensors, path);
+}
+
+zone_assigner::zone_assigner(const pca_model &model, const torch::Tensor &centroids, zone_assigner_options options)
+    : options(options), queue(options.window, options.max_batch)
+{
+    torch::NoGradGuard no_grad;
+    auto mean = model.mean.to(torch::kCPU, torch::kFloat).reshape({1, -1});
+    auto W = model.components.to(torch::kCPU, torch::kFloat);
+    auto C = centroids.to(torch::kCPU, torch::kFloat);
+    if (W.size(1) != C.size(1))
+    {
+        throw std::invalid_argument("Centroid dimension does not match the number of PCA components");
+    }
+
+    // Fold the projection into the centroid scores once, at load time
+    n_features = W.size(0);
+    weights = torch::matmul(W, C.t()).contiguous();
+    bias = (C.square().sum(1).unsqueeze(0) + 2 * torch::matmul(mean, weights)).contiguous();
+
+    input = torch::empty({options.max_batch, n_features}, torch::kFloat);
+    scores = torch::empty({options.max_batch, C.size(0)}, torch::kFloat);
+
+    dispatcher = std::thread(&zone_assigner::dispatch_loop, this);
+}
+
+std::unique_ptr<zone_assigner> zone_assigner::load(const std::string &path, zone_assigner_options options)
+{
+    std::vector<torch::Tensor> tensors;
+    torch::load(tensors, path);
+    if (tensors.size() != 3)
+    {
+        throw std::runtime_error("Not a zone model file: " + path);
+    }
+
+    pca_model model;
+    model.mean = tensors[0];
+    model.components = tensors[1];
+    return std::make_unique<zone_assigner>(model, tensors[2], options);
+}
+
+zone_assigner::~zone_assigner()
+{
+    queue.close();
+    if (dispatcher.joinable())
+        dispatcher.join();
+}
+
+std::future<int64_t> zone_assigner::submit(std::vector<float> fingerprint)
+{
+    if ((int64_t)fingerprint.size() != n_features)
+    {
+        throw std::invalid_argument("Fingerprint has " + std::to_string(fingerprint.size()) + " features, expected " +
+                                    std::to_string(n_features));
+    }
+
+    request r;
+    r.fingerprint = std::move(fingerprint);
+    auto zone = r.zone.get_future();
+    if (!queue.push(std::move(r)))
+    {
+        throw std::runtime_error("zone_assigner is shutting down");
+    }
+    return zone;
+}
+
+int64_t zone_assigner::assign(std::vector<float> fingerprint)
+{
+    return submit(std::move(fingerprint)).get();
+}
+
+void zone_assigner::dispatch_loop()
+{
+    c10::InferenceMode guard;
+    std::vector<request> batch;
+    batch.reserve(options.max_batch);
+
+    while (queue.next(batch))
+    {
+        run_batch(batch);
+        batch.clear();
+    }
+}
+
+void zone_assigner::run_batch(std::vector<request> &batch)
+{
+    const int64_t b = (int64_t)batch.size();
+    torch::Tensor zones;
+    try
+    {
+        float *dst = input.data_ptr<float>();
+        for (int64_t i = 0; i < b; ++i)
+            std::copy(batch[i].fingerprint.begin(), batch[i].fingerprint.end(), dst + i * n_features);
+
+        auto x = input.slice(0, 0, b);
+        auto s = scores.slice(0, 0, b);
+        torch::addmm_out(s, bias, x, weights, /*beta=*/1, /*alpha=*/-2);
+        zones = s.argmin(1);
+    }
+    catch (...)
+    {
+        for (int64_t i = 0; i < b; ++i)
+            batch[i].zone.set_exception(std::current_exception());
+        return;
+    }
+
+    const int64_t *zp = zones.data_ptr<int64_t>();
+    auto done = std::chrono::steady_clock::now();
+    for (int64_t i = 0; i < b; ++i)
+        batch[i].zone.set_value(zp[i]);
+    latencies.record(batch, done);
+}
+
+zone_assigner_stats zone_assigner::stats()
+{
+    return latencies.stats();
+}
@@ -0,0 +1,58 @@
+#include <db/access/cell_rollup.hpp>
+#include <db/access/measurement_batch.hpp>
+#include <support/check.hpp>
+#include <string>
+#include <vector>
+
+using test_support::check;
+
+namespace {
+    // Shaped like an OpenCellID CSV row: no per-row signal, only avg_signal
+    measurement csv_row(int64_t i, int32_t avg_signal) {
+        measurement m;
+        m.key.mcc = 262;
+        m.key.mnc = 1;
+        m.key.lac = 40;
+        m.key.cellid = 1234;
+        m.key.measured_at = 1700000000000LL + i * 1000;
+        m.radio = "LTE";
+        m.stats_data.samples = 5;
+        m.stats_data.avg_signal = avg_signal;
+        return m;
+    }
+
+    void check_single_bucket(const rollup_aggregator &aggregator, const std::string &name) {
+        auto pending = aggregator.pending_buckets();
+        check(pending.size() == 1, name + ": one bucket");
+        if (pending.size() != 1)
+            return;
+        const rollup_aggregate &a = pending[0].second;
+        // Rows: avg_signal -90, -70, absent, and signal -60 over avg_signal -100
+        check(a.samples == 4, name + ": samples");
+        check(a.signal_count == 3, name + ": signal_count");
+        check(a.signal_sum == -220, name + ": signal_sum");
+        check(a.signal_min == -90 && a.signal_max == -60, name + ": signal min/max");
+        check(a.signal_sketch.count() == 3, name + ": sketch count");
+        check(a.avg_signal() == -220.0 / 3, name + ": avg_signal");
+    }
+}
+
+int main() {
+    std::vector<measurement> rows = {csv_row(0, -90), csv_row(1, -70), csv_row(2, 0), csv_row(3, -100)};
+    rows[3].movement_data.signal = -60; // a row that has both keeps its own signal
+
+    // 1. Row by row
+    rollup_aggregator by_row;
+    for (const auto &m : rows)
+        by_row.add(m);
+    check_single_bucket(by_row, "add(measurement)");
+
+    // 2. As a batch, with signal null and avg_signal set as insert_csv builds it
+    auto batch = measurement_batch::from_rows(rows);
+    check(!batch.signal.valid(0) && batch.avg_signal.valid(0), "batch is CSV-shaped");
+    rollup_aggregator by_batch;
+    by_batch.add(batch);
+    check_single_bucket(by_batch, "add(measurement_batch)");
+
+    return test_support::finish("cell_rollup");
+}
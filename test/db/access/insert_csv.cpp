@@ -6,18 +6,105 @@
 #include <sstream>
 #include <vector>
 #include <config.hpp>
+#include <db/access/cell_rollup.hpp>
 #include <db/access/measurement.hpp>
+#include <db/access/measurement_batch.hpp>
 #include <db/connector.hpp>
+#include <db/schema.hpp>
+#include <trace/trace.hpp>
 
 class data_importer
 {
+private:
+    // Rows sent per measurement_manager::insert(batch) call
+    static const size_t batch_rows = 5000;
+
+    // Columns the OpenCellID export does not carry
+    static void push_absent(measurement_batch &batch)
+    {
+        for (auto *c : {&batch.rating, &batch.speed, &batch.direction})
+            c->push_null();
+        for (auto *c : {&batch.signal, &batch.ta, &batch.tac, &batch.pci, &batch.sid, &batch.nid, &batch.bid})
+            c->push_null();
+        batch.apikey.push_null();
+        batch.devn.push_null();
+    }
+
+    // Parses one line (radio, mcc, mnc, lac, cellid, unit, lon, lat, range, samples,
+    // changeable, created, updated, avg_signal) and appends it to the batch. Throws on a
+    // malformed line before anything is appended.
+    static void parse_line(const std::string &line, measurement_batch &batch)
+    {
+        std::vector<std::string> fields;
+        std::stringstream ss(line);
+        std::string field;
+        while (std::getline(ss, field, ','))
+            fields.push_back(field);
+        if (fields.size() < 13)
+            throw std::runtime_error("expected at least 13 fields, got " + std::to_string(fields.size()));
+
+        int32_t mcc = std::stoi(fields[1]), mnc = std::stoi(fields[2]), lac = std::stoi(fields[3]);
+        int64_t cellid = std::stoll(fields[4]);
+        int32_t unit = std::stoi(fields[5]);
+        double lon = std::stod(fields[6]), lat = std::stod(fields[7]);
+        int32_t range = std::stoi(fields[8]), samples = std::stoi(fields[9]), changeable = std::stoi(fields[10]);
+        // Seconds → ms
+        int64_t created_ms = std::stoll(fields[11]) * 1000, updated_ms = std::stoll(fields[12]) * 1000;
+        // The last field is often empty
+        bool has_signal = fields.size() > 13 && !fields[13].empty();
+        int32_t avg_signal = has_signal ? std::stoi(fields[13]) : 0;
+
+        batch.mcc.push_back(mcc);
+        batch.mnc.push_back(mnc);
+        batch.lac.push_back(lac);
+        batch.cellid.push_back(cellid);
+        batch.measured_at.push_back(created_ms);
+
+        batch.lat.push_back(lat);
+        batch.lon.push_back(lon);
+        batch.range.push_back(range);
+        batch.radio.push_back(fields[0]);
+
+        batch.unit.push_back(unit);
+        batch.samples.push_back(samples);
+        batch.changeable.push_back(changeable);
+        if (has_signal)
+            batch.avg_signal.push_back(avg_signal);
+        else
+            batch.avg_signal.push_null();
+        batch.created_at.push_back(created_ms);
+        batch.updated_at.push_back(updated_ms);
+
+        push_absent(batch);
+    }
+
+    static const std::vector<std::string> &mcc_list()
+    {
+        static const std::vector<std::string> list = {"310", "311", "312", "313", "314", "315"};
+        return list;
+    }
+
 public:
+    // Names the imported files (FNV-1a of their paths), so a re-import writes its rollup
+    // rows under the same flush_ids and overwrites them
+    static uint64_t source_id()
+    {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (const auto &mcc : mcc_list())
+            for (char c : std::string(OCID_DSET_PATH) + "/" + mcc + ".csv")
+                h = (h ^ (unsigned char)c) * 0x100000001b3ULL;
+        return h;
+    }
+
     static void import_csv(measurement_manager &manager)
     {
-        std::vector<std::string> mcc_list = {"310", "311", "312", "313", "314", "315"};
+        trace_span span("import_csv", "csv");
         std::string root_path = OCID_DSET_PATH;
-        for (const auto &mcc : mcc_list)
+        measurement_batch batch;
+        batch.reserve(batch_rows);
+        for (const auto &mcc : mcc_list())
         {
+            trace_span file_span("import_csv.file", "csv");
             std::string csv_file = root_path + "/" + mcc + ".csv";
             std::ifstream file(csv_file);
             if (!file.is_open())
@@ -26,108 +113,44 @@ public:
             }
 
             std::string line;
-            int count = 0;
-            std::cout << "Starting import from " << OCID_DSET_PATH << "..." << std::endl;
+            size_t line_no = 0, count = 0;
+            std::cout << "Starting import from " << csv_file << "..." << std::endl;
 
             while (std::getline(file, line))
             {
+                ++line_no;
                 if (line.empty())
                     continue;
 
-                // Use stringstream to parse the line
-                // Based on your previous sample: radio, mcc, mnc, lac, cellid, unit, lon, lat, range...
-                std::stringstream ss(line);
-                std::string field;
-                measurement m;
-
                 try
                 {
-                    // 1. Radio (String)
-                    std::getline(ss, field, ',');
-                    m.radio = field;
-
-                    // 2. MCC (Int)
-                    std::getline(ss, field, ',');
-                    m.key.mcc = std::stoi(field);
-
-                    // 3. MNC (Int)
-                    std::getline(ss, field, ',');
-                    m.key.mnc = std::stoi(field);
-
-                    // 4. LAC (Int)
-                    std::getline(ss, field, ',');
-                    m.key.lac = std::stoi(field);
-
-                    // 5. CellID (Int)
-                    std::getline(ss, field, ',');
-                    m.key.cellid = std::stoi(field);
-
-                    // 6. Unit (Int)
-                    std::getline(ss, field, ',');
-                    m.stats_data.unit = std::stoi(field);
-
-                    // 7. Lon (Double)
-                    std::getline(ss, field, ',');
-                    m.core_data.lon = std::stod(field);
-
-                    // 8. Lat (Double)
-                    std::getline(ss, field, ',');
-                    m.core_data.lat = std::stod(field);
-
-                    // 9. Range (Int)
-                    std::getline(ss, field, ',');
-                    m.core_data.range = std::stoi(field);
-
-                    // 10. Samples (Int)
-                    std::getline(ss, field, ',');
-                    m.stats_data.samples = std::stoi(field);
-
-                    // 11. Changeable (Int)
-                    std::getline(ss, field, ',');
-                    m.stats_data.changeable = std::stoi(field);
-
-                    // 12. Created (Long -> ms)
-                    std::getline(ss, field, ',');
-                    int64_t created_ms = std::stoll(field) * 1000;
-                    m.key.measured_at = created_ms;
-                    m.stats_data.created_at = created_ms;
-
-                    // 13. Updated (Long -> ms)
-                    std::getline(ss, field, ',');
-                    m.stats_data.updated_at = std::stoll(field) * 1000;
-
-                    // 14. Avg Signal (Int) - Final field, no delimiter needed but safe to include
-                    std::getline(ss, field, ',');
-                    if (!field.empty())
-                        m.stats_data.avg_signal = std::stoi(field);
-
-                    // Execute insertion
-                    measurement record = manager.get_measurement(m.key.mcc, m.key.mnc, m.key.lac, m.key.cellid, m.key.measured_at); // Test retrieval before insertion
-                    std::string record_str = measurement_manager::to_string(record, false);
-                    std::string expected_str = measurement_manager::to_string(m, false);
-                    if (record_str != expected_str)
-                    {
-                        std::cout << "Record not found before insertion, as expected." << std::endl;
-                        std::cout << "Inserting measurement: " << expected_str << std::endl;
-                        manager.insert(m);
-                    }
-                    else
-                    {
-                        std::cout << "Record already exists before insertion: " << record_str << std::endl;
-                    }
-
-                    count++;
-                    if (count % 1000 == 0)
-                    {
-                        std::cout << "Inserted " << count << " rows..." << std::endl;
-                    }
+                    int64_t parse_start = tracer::enabled() ? tracer::now_ns() : 0;
+                    parse_line(line, batch);
+                    if (parse_start)
+                        tracer::record("import_csv.parse", "csv", parse_start, tracer::now_ns());
                 }
                 catch (const std::exception &e)
                 {
-                    std::cerr << "Skip malformed line " << count << ": " << e.what() << std::endl;
+                    std::cerr << "Skip malformed line " << line_no << ": " << e.what() << std::endl;
+                    continue;
+                }
+
+                // Inserts are upserts, so re-importing a file only rewrites its rows
+                if (batch.size() >= batch_rows)
+                {
+                    manager.insert(batch);
+                    count += batch.size();
+                    batch.clear();
+                    std::cout << "Inserted " << count << " rows..." << std::endl;
                 }
             }
 
+            if (!batch.empty())
+            {
+                manager.insert(batch);
+                count += batch.size();
+                batch.clear();
+            }
             std::cout << "Import Complete. Total rows: " << count << std::endl;
             file.close();
         }
@@ -139,8 +162,17 @@ public:
 int main()
 {
     connector db;
-    db.connect("172.18.0.2", "open_cell_id");
-    measurement_manager manager(db);
+    db.connect("172.18.0.2");
+    schema::create(db);
+    // Per-cell and per-hour rollups are built while importing and written once at the end;
+    // keyed by the source files, so importing them again replaces the rows
+    rollup_options options;
+    options.source_id = data_importer::source_id();
+    rollup_aggregator rollups(options);
+    measurement_manager manager(db, &rollups);
+    // TRACE_OUT=<file.json> records where the import spends its time
+    trace_session trace(trace_session::path_from_env());
     data_importer::import_csv(manager);
+    std::cout << "Rollup rows written: " << rollups.flush(db) << std::endl;
     return 0;
 }
\ No newline at end of file
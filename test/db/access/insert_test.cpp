@@ -1,4 +1,6 @@
 #include <db/access/measurement.hpp>
+#include <db/access/measurement_batch.hpp>
+#include <db/access/signal_update_buffer.hpp>
 #include <db/connector.hpp>
 
 int main() {
@@ -27,6 +29,34 @@ int main() {
         std::cout << manager.to_string(record, true) << std::endl;
     }
 
+    // Time range of one cell, newest first
+    measurement_range range;
+    range.mcc = 310;
+    range.mnc = 410;
+    range.lac = 123;
+    range.cellid = 456;
+    range.start_ms = 1710000000000 - 3600000;
+    range.end_ms = 1710000000000 + 3600000;
+    range.descending = true;
+    range.fields = {columns.signal, columns.radio};
+    auto page = manager.get_measurement_range(range);
+    std::cout << "Found " << page.rows.size() << " records within an hour of it." << std::endl;
+    for (const auto& record : page.rows.to_rows()) {
+        std::cout << manager.to_string(record, true) << std::endl;
+    }
+
+    // Many keys at once, concurrently, results in input order
+    keys k;
+    k.mcc = 310;
+    k.mnc = 410;
+    k.lac = 123;
+    k.cellid = 456;
+    k.measured_at = 1710000000000;
+    auto found = manager.get_measurements(std::vector<keys>(3, k));
+    auto towers = manager.get_tower_locations({k});
+    std::cout << "Looked up " << found.size() << " keys, tower at " << towers[0].lat << ", " << towers[0].lon
+              << std::endl;
+
     // 3. Update
     manager.update_signal(310, 410, 123, 456, 1710000000000, -80);
     std::cout << "Found " << list.size() << " records for this provider." << std::endl;
@@ -35,6 +65,16 @@ int main() {
         std::cout << manager.to_string(record, true) << std::endl;
     }
 
+    // Live feed: repeated updates of one row collapse into a single write
+    {
+        signal_update_buffer updates(manager);
+        for (int32_t signal = -100; signal <= -70; ++signal) {
+            updates.update(310, 410, 123, 456, 1710000000000, signal);
+        }
+        updates.shutdown();
+        std::cout << "Collapse ratio: " << updates.stats().collapse_ratio() << std::endl;
+    }
+
     // 4. Delete
     manager.remove(310, 410, 123, 456, 1710000000000);
 
@@ -0,0 +1,120 @@
+#include <db/access/measurement_batch.hpp>
+#include <support/check.hpp>
+#include <string>
+#include <vector>
+
+using test_support::check;
+
+namespace {
+    bool same(const measurement &a, const measurement &b) {
+        return a.key == b.key && a.core_data.lat == b.core_data.lat && a.core_data.lon == b.core_data.lon &&
+               a.core_data.rating == b.core_data.rating && a.core_data.range == b.core_data.range &&
+               a.radio == b.radio && a.apikey == b.apikey && a.devn == b.devn &&
+               a.stats_data.unit == b.stats_data.unit && a.stats_data.samples == b.stats_data.samples &&
+               a.stats_data.changeable == b.stats_data.changeable && a.stats_data.avg_signal == b.stats_data.avg_signal &&
+               a.stats_data.created_at == b.stats_data.created_at && a.stats_data.updated_at == b.stats_data.updated_at &&
+               a.movement_data.signal == b.movement_data.signal && a.movement_data.speed == b.movement_data.speed &&
+               a.movement_data.direction == b.movement_data.direction && a.tech.ta == b.tech.ta &&
+               a.tech.tac == b.tech.tac && a.tech.pci == b.tech.pci && a.tech.sid == b.tech.sid &&
+               a.tech.nid == b.tech.nid && a.tech.bid == b.tech.bid;
+    }
+
+    measurement sample(int64_t i, const std::string &radio) {
+        measurement m;
+        m.key.mcc = 310;
+        m.key.mnc = 410;
+        m.key.lac = 7 + (int32_t)(i % 3);
+        m.key.cellid = 5000000000LL + i;
+        m.key.measured_at = 1700000000000LL + i * 1000;
+        m.radio = radio;
+        // Every other row leaves the optional fields at 0/"" (null in the batch)
+        if (i % 2 == 0) {
+            m.core_data.lat = 40.0 + i * 0.001;
+            m.core_data.lon = -74.0 - i * 0.001;
+            m.core_data.rating = 0.5;
+            m.core_data.range = 1000 + (int32_t)i;
+            m.apikey = "key" + std::to_string(i % 4);
+            m.devn = "dev";
+            m.stats_data.unit = 3;
+            m.stats_data.samples = 12;
+            m.stats_data.changeable = 1;
+            m.stats_data.avg_signal = -95;
+            m.stats_data.created_at = m.key.measured_at;
+            m.stats_data.updated_at = m.key.measured_at + 60000;
+            m.movement_data.signal = -80 - (int32_t)(i % 40);
+            m.movement_data.speed = 12.5;
+            m.movement_data.direction = 270;
+            m.tech.ta = 4;
+            m.tech.tac = 21;
+            m.tech.pci = 301;
+            m.tech.sid = 5;
+            m.tech.nid = 6;
+            m.tech.bid = 7;
+        }
+        return m;
+    }
+}
+
+int main() {
+    // 1. validity_bitmap across word boundaries
+    validity_bitmap bits;
+    const size_t n_bits = 200;
+    for (size_t i = 0; i < n_bits; ++i)
+        bits.push_back(i % 3 == 0);
+    check(bits.size() == n_bits, "bitmap size");
+    size_t expected_count = 0;
+    for (size_t i = 0; i < n_bits; ++i) {
+        check(bits.get(i) == (i % 3 == 0), "bitmap get " + std::to_string(i));
+        expected_count += i % 3 == 0;
+    }
+    check(bits.count() == expected_count, "bitmap count");
+    // Clear the last bit of the first word, set two at the start of the second
+    bits.set(63, false);
+    bits.set(64, true);
+    bits.set(65, true);
+    check(!bits.get(63) && bits.get(64) && bits.get(65), "bitmap set");
+    check(bits.count() == expected_count + 1, "bitmap count after set");
+
+    bits.clear();
+    check(bits.size() == 0 && bits.count() == 0, "bitmap clear");
+
+    // 2. from_rows / to_rows round trip; zeros become nulls and come back as zeros
+    std::vector<measurement> rows;
+    const char *radios[] = {"LTE", "GSM", "UMTS"};
+    for (int64_t i = 0; i < 150; ++i)
+        rows.push_back(sample(i, radios[i % 3]));
+    auto batch = measurement_batch::from_rows(rows);
+    check(batch.size() == rows.size(), "from_rows size");
+    check(batch.radio.dictionary.size() == 3, "radio dictionary holds each string once");
+    check(batch.signal.validity.count() == 75 && !batch.signal.valid(1) && batch.signal.valid(0),
+          "zero signal stored as null");
+    check(batch.apikey.at(1).empty() && !batch.apikey.valid(1), "empty apikey stored as null");
+    auto back = batch.to_rows();
+    check(back.size() == rows.size(), "to_rows size");
+    for (size_t i = 0; i < rows.size() && i < back.size(); ++i)
+        check(same(rows[i], back[i]), "round trip row " + std::to_string(i));
+
+    // 3. append(other, i) re-encodes strings into the target's dictionary and keeps nulls
+    measurement_batch target;
+    target.append(sample(1000, "NR"));
+    target.append(sample(1001, "GSM"));
+    std::vector<size_t> picked = {5, 4, 1, 0, 149};
+    for (size_t i : picked)
+        target.append(batch, i);
+    check(target.size() == 2 + picked.size(), "append size");
+    // NR, GSM, then UMTS (row 5), LTE (row 0)
+    check(target.radio.dictionary.size() == 4, "target dictionary grows only by new strings");
+    // LTE is code 0 in the source but code 3 in the target
+    check(batch.radio.codes.values[0] == 0 && target.radio.codes.values[5] == 3, "appended string re-encoded");
+    for (size_t j = 0; j < picked.size(); ++j) {
+        size_t i = picked[j], t = 2 + j;
+        check(same(target.row(t), batch.row(i)), "appended row " + std::to_string(i));
+        check(target.radio.at(t) == batch.radio.at(i), "appended radio " + std::to_string(i));
+        check(target.signal.valid(t) == batch.signal.valid(i) && target.devn.valid(t) == batch.devn.valid(i) &&
+                  target.speed.valid(t) == batch.speed.valid(i),
+              "appended validity " + std::to_string(i));
+    }
+    check(target.radio.at(0) == "NR" && target.radio.at(1) == "GSM", "existing rows unchanged");
+
+    return test_support::finish("measurement_batch");
+}
@@ -0,0 +1,101 @@
+#include <db/access/cell_rollup.hpp>
+#include <support/check.hpp>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using test_support::check;
+
+namespace {
+    // Same rank convention as quantile_sketch::quantile
+    double exact_quantile(const std::vector<double> &sorted, double q) {
+        return sorted[(size_t)std::floor(q * (double)(sorted.size() - 1))];
+    }
+
+    const std::vector<double> qs = {0.0, 0.01, 0.05, 0.1, 0.25, 0.5, 0.75, 0.9, 0.95, 0.99, 1.0};
+}
+
+int main() {
+    const double accuracy = 0.01;
+    std::mt19937_64 rng(7);
+
+    // 1. Quantiles within relative_accuracy of the exact ones: integer dBm, then a mix of
+    // negative, zero and positive reals spanning several orders of magnitude
+    std::vector<double> dbm, mixed;
+    std::uniform_int_distribution<int> signal(-140, -20);
+    for (int i = 0; i < 50000; ++i)
+        dbm.push_back(signal(rng));
+    std::lognormal_distribution<double> magnitude(0.0, 3.0);
+    std::bernoulli_distribution negative(0.4);
+    for (int i = 0; i < 50000; ++i)
+        mixed.push_back(i % 50 == 0 ? 0.0 : (negative(rng) ? -1 : 1) * magnitude(rng));
+
+    for (const auto *values : {&dbm, &mixed}) {
+        const std::string name = values == &dbm ? "dBm" : "mixed";
+        quantile_sketch sketch(accuracy);
+        for (double v : *values)
+            sketch.add(v);
+        check(sketch.count() == values->size(), name + " count");
+
+        std::vector<double> sorted = *values;
+        std::sort(sorted.begin(), sorted.end());
+        for (double q : qs) {
+            double exact = exact_quantile(sorted, q), estimate = sketch.quantile(q);
+            check(std::abs(estimate - exact) <= accuracy * std::abs(exact) + 1e-12,
+                  name + " q=" + std::to_string(q) + ": estimate " + std::to_string(estimate) + ", exact " +
+                      std::to_string(exact));
+        }
+    }
+    check(std::isnan(quantile_sketch(accuracy).quantile(0.5)), "empty sketch returns NaN");
+
+    // 2. Merging per-part sketches equals one sketch over all values
+    quantile_sketch combined(accuracy), merged(accuracy);
+    std::vector<quantile_sketch> parts(4, quantile_sketch(accuracy));
+    for (size_t i = 0; i < mixed.size(); ++i) {
+        combined.add(mixed[i]);
+        parts[i % parts.size()].add(mixed[i]);
+    }
+    for (const auto &part : parts)
+        merged.merge(part);
+    check(merged.count() == combined.count(), "merged count");
+    check(merged.serialize() == combined.serialize(), "merged bins equal combined bins");
+    for (double q : qs)
+        check(merged.quantile(q) == combined.quantile(q), "merged quantile " + std::to_string(q));
+
+    bool threw = false;
+    try {
+        merged.merge(quantile_sketch(0.02));
+    } catch (const std::invalid_argument &) {
+        threw = true;
+    }
+    check(threw, "merge rejects a different accuracy");
+
+    // 3. serialize / deserialize round trip, negative dBm included
+    quantile_sketch rssi(accuracy);
+    for (double v : dbm)
+        rssi.add(v);
+    for (const auto *sketch : {&rssi, &combined}) {
+        std::string bytes = sketch->serialize();
+        quantile_sketch back = quantile_sketch::deserialize(bytes);
+        check(back.count() == sketch->count(), "round trip count");
+        check(back.relative_accuracy() == sketch->relative_accuracy(), "round trip accuracy");
+        check(back.serialize() == bytes, "round trip bytes");
+        for (double q : qs)
+            check(back.quantile(q) == sketch->quantile(q), "round trip quantile " + std::to_string(q));
+    }
+    check(quantile_sketch::deserialize(quantile_sketch(accuracy).serialize()).count() == 0, "empty round trip");
+
+    threw = false;
+    try {
+        std::string bytes = rssi.serialize();
+        quantile_sketch::deserialize(bytes.substr(0, bytes.size() - 3));
+    } catch (const std::invalid_argument &) {
+        threw = true;
+    }
+    check(threw, "truncated input rejected");
+
+    return test_support::finish("quantile_sketch");
+}
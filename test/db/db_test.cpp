@@ -1,4 +1,5 @@
 #include "db/connector.hpp"
+#include "db/schema.hpp"
 
 int main() {
     try {
@@ -32,6 +33,12 @@ int main() {
         cass_statement_free(statement);
         cass_prepared_free(prepared);
 
+        // 5. Project schema: keyspace open_cell_id with the measurement and rollup tables
+        schema_options options;
+        options.layout = measurement_layout::by_bucket();
+        schema::create(db, options);
+        std::cout << "Schema ready in " << options.keyspace << std::endl;
+
     } catch (const std::exception& e) {
         std::cerr << "ERROR: " << e.what() << std::endl;
         return 1;
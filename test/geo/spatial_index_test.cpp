@@ -0,0 +1,71 @@
+#include <geo/spatial_index.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+
+int main() {
+    // 1. Random towers over the continental US
+    const size_t n = 1000000;
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> lat_dist(25.0, 49.0), lon_dist(-125.0, -67.0);
+
+    std::vector<keys> ks(n);
+    std::vector<core> locations(n);
+    for (size_t i = 0; i < n; ++i) {
+        ks[i].mcc = 310;
+        ks[i].mnc = 410;
+        ks[i].cellid = (int64_t)i + 1;
+        locations[i].lat = lat_dist(rng);
+        locations[i].lon = lon_dist(rng);
+    }
+
+    spatial_index index(0.01);
+    auto start = std::chrono::steady_clock::now();
+    index.build(ks, locations);
+    auto build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Built index over " << index.size() << " towers in " << build_ms << " ms" << std::endl;
+
+    // 2. Radius queries must match a brute-force scan
+    int failures = 0;
+    double query_us = 0;
+    const int n_queries = 200;
+    for (int q = 0; q < n_queries; ++q) {
+        double lat = lat_dist(rng), lon = lon_dist(rng), radius = 500.0 + q * 50.0;
+
+        auto t0 = std::chrono::steady_clock::now();
+        auto hits = index.within_radius(lat, lon, radius);
+        query_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+
+        std::vector<int64_t> got, expected;
+        for (size_t i : hits)
+            got.push_back(index.key(i).cellid);
+        for (size_t i = 0; i < n; ++i)
+            if (spatial_index::haversine_m(lat, lon, locations[i].lat, locations[i].lon) <= radius)
+                expected.push_back(ks[i].cellid);
+        std::sort(got.begin(), got.end());
+        std::sort(expected.begin(), expected.end());
+        if (got != expected) {
+            std::cerr << "Radius query " << q << " returned " << got.size() << " towers, expected " << expected.size() << std::endl;
+            failures++;
+        }
+    }
+    std::cout << "Mean radius query: " << query_us / n_queries << " us" << std::endl;
+
+    // 3. Bounding box, including one that wraps the antimeridian
+    auto box = index.within_box(40.0, -75.0, 41.0, -73.0);
+    size_t expected_box = std::count_if(locations.begin(), locations.end(), [](const core &c) {
+        return c.lat >= 40.0 && c.lat <= 41.0 && c.lon >= -75.0 && c.lon <= -73.0;
+    });
+    if (box.size() != expected_box) {
+        std::cerr << "Box query returned " << box.size() << ", expected " << expected_box << std::endl;
+        failures++;
+    }
+    if (!index.within_box(40.0, 170.0, 41.0, -170.0).empty()) {
+        std::cerr << "Antimeridian box should be empty for US towers" << std::endl;
+        failures++;
+    }
+
+    std::cout << (failures == 0 ? "All spatial index checks passed." : "Spatial index checks FAILED.") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
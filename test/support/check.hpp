@@ -0,0 +1,28 @@
+#ifndef TEST_SUPPORT_CHECK_HPP
+#define TEST_SUPPORT_CHECK_HPP
+
+#include <iostream>
+#include <string>
+
+// Assertions for the test executables: check() reports a failed condition and carries on,
+// so one run lists every failure; finish() prints the summary and returns main's exit code.
+namespace test_support {
+    inline int &failures() {
+        static int count = 0;
+        return count;
+    }
+
+    inline void check(bool ok, const std::string &what) {
+        if (!ok) {
+            std::cerr << "FAILED: " << what << std::endl;
+            failures()++;
+        }
+    }
+
+    inline int finish(const std::string &suite) {
+        std::cout << (failures() == 0 ? "All " + suite + " checks passed." : suite + " checks FAILED.") << std::endl;
+        return failures() == 0 ? 0 : 1;
+    }
+}
+
+#endif // TEST_SUPPORT_CHECK_HPP
@@ -0,0 +1,72 @@
+#include <unsupervised/bounded_kmeans.hpp>
+#include <unsupervised/kmeans.hpp>
+#include <support/check.hpp>
+#include <ATen/CPUGeneratorImpl.h>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+using test_support::check;
+
+namespace {
+    // The variants compute distances in different orders (GEMM form vs direct sums), so a
+    // point almost equidistant from two centroids may land on either side
+    const double max_mismatch = 1e-4, inertia_rtol = 1e-5;
+
+    // Sum of squared distances to the cluster means of 'labels', computed the same way for
+    // every variant (the bounded ones do not return centroids)
+    double inertia_of(const torch::Tensor &data, const torch::Tensor &labels, int K) {
+        auto sums = torch::zeros({K, data.size(1)}, torch::kDouble).index_add_(0, labels, data.to(torch::kDouble));
+        auto counts = torch::zeros({K}, torch::kDouble).index_add_(0, labels, torch::ones({data.size(0)}, torch::kDouble));
+        auto means = sums / counts.clamp_min(1).unsqueeze(1);
+        return (data.to(torch::kDouble) - means.index_select(0, labels)).square().sum().item<double>();
+    }
+}
+
+int main() {
+    torch::NoGradGuard no_grad;
+    const int64_t n = 20000, d = 8;
+    const int K = 16, max_iters = 300;
+    const float tol = 1e-7f;
+
+    // Overlapping Gaussian blobs, so the bounds have to prove most skips rather than all
+    auto generator = at::make_generator<at::CPUGeneratorImpl>(1234);
+    auto centers = torch::rand({K, d}, generator) * 20 - 10;
+    auto member = torch::randint(0, K, {n}, generator, torch::kLong);
+    auto data = (centers.index_select(0, member) + torch::randn({n, d}, generator) * 1.5).contiguous();
+    auto init = data.index_select(0, torch::randperm(n, generator, torch::kLong).slice(0, 0, K)).contiguous();
+
+    // 1. Same start → same assignments and inertia
+    kmeans_options options(K);
+    options.max_iters = max_iters;
+    options.tol = tol;
+    options.init_centroids = init;
+    auto lloyd = kmeans_fit(data, options);
+
+    kmeans_stats hamerly_stats, elkan_stats;
+    auto hamerly = kmeans_hamerly(data, K, max_iters, tol, &hamerly_stats, false, 0, init);
+    auto elkan = kmeans_elkan(data, K, max_iters, tol, &elkan_stats, false, 0, init);
+
+    double lloyd_inertia = inertia_of(data, lloyd.labels, K);
+    check(std::abs(lloyd_inertia - lloyd.inertia) <= 1e-4 * lloyd_inertia, "Lloyd inertia matches its centroids");
+    for (const auto &variant : {std::make_pair("Hamerly", hamerly), std::make_pair("Elkan", elkan)}) {
+        const std::string name = variant.first;
+        double mismatch = variant.second.ne(lloyd.labels).sum().item<int64_t>() / (double)n;
+        double inertia = inertia_of(data, variant.second, K);
+        std::cout << name << ": " << mismatch * n << " labels differ from Lloyd's, inertia " << inertia
+                  << ", Lloyd " << lloyd_inertia << std::endl;
+        check(mismatch <= max_mismatch, name + " assignments match Lloyd's");
+        check(std::abs(inertia - lloyd_inertia) <= inertia_rtol * lloyd_inertia, name + " inertia");
+    }
+    check(hamerly_stats.distances_skipped > 0 && elkan_stats.distances_skipped > 0, "bounds skipped some distances");
+
+    // 2. Seeded random starts are reproducible
+    auto a = kmeans_hamerly(data, K, max_iters, tol, nullptr, false, 7);
+    auto b = kmeans_hamerly(data, K, max_iters, tol, nullptr, false, 7);
+    check(torch::equal(a, b), "Hamerly with the same seed");
+    a = kmeans_elkan(data, K, max_iters, tol, nullptr, false, 7);
+    b = kmeans_elkan(data, K, max_iters, tol, nullptr, false, 7);
+    check(torch::equal(a, b), "Elkan with the same seed");
+
+    return test_support::finish("k-means equivalence");
+}
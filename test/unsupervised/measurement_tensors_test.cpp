@@ -0,0 +1,30 @@
+#include <unsupervised/measurement_tensors.hpp>
+#include <support/check.hpp>
+#include <string>
+
+using test_support::check;
+
+int main() {
+    // 1. validity_mask unpacks the bitmap, including partial and exact last words
+    for (size_t n : {size_t(0), size_t(1), size_t(63), size_t(64), size_t(65), size_t(200)}) {
+        validity_bitmap bits;
+        for (size_t i = 0; i < n; ++i)
+            bits.push_back(i % 3 == 0 || i == 64);
+        auto mask = validity_mask(bits);
+        check(mask.dim() == 1 && mask.size(0) == (int64_t)n, "mask size for " + std::to_string(n) + " rows");
+        auto acc = mask.accessor<bool, 1>();
+        for (size_t i = 0; i < n && i < (size_t)mask.size(0); ++i)
+            check(acc[i] == bits.get(i), "mask bit " + std::to_string(i) + " of " + std::to_string(n));
+    }
+
+    // 2. column_tensor aliases the column's memory
+    column<int32_t> signal;
+    for (int32_t v : {-80, -95, 0, -110})
+        signal.push_back(v);
+    auto view = column_tensor(signal);
+    check(view.data_ptr<int32_t>() == signal.values.data() && view.size(0) == 4, "column_tensor is zero-copy");
+    view[1] = -60;
+    check(signal.values[1] == -60, "writes through the tensor reach the column");
+
+    return test_support::finish("measurement_tensors");
+}